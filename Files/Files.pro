@@ -1,5 +1,5 @@
 QT       += core gui
-QT += charts
+QT += charts concurrent
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
@@ -15,8 +15,6 @@ SOURCES += \
     dashboard.cpp \
     decompression.cpp \
     history.cpp \
-    huffman.cpp \
-    imagecom.cpp \
     main.cpp \
     mainscreen.cpp \
     mainwindow.cpp \
@@ -30,8 +28,6 @@ HEADERS += \
     dashboard.h \
     decompression.h \
     history.h \
-    huffman.h \
-    imagecom.h \
     mainscreen.h \
     mainwindow.h \
     selectionscreen.h \
@@ -40,12 +36,5 @@ HEADERS += \
     visualizer.h
 
 
-INCLUDEPATH += C:/opencv/build_mingw/include
-LIBS += -LC:/opencv/build_mingw/x64/mingw/lib \
-    -lopencv_core455 \
-    -lopencv_imgcodecs455 \
-    -lopencv_highgui455 \
-    -lopencv_imgproc455\
-    -lopencv_videoio455 \
-    -lopencv_video455
-
+# Engine sources and OpenCV, shared with the command-line tool
+include(engine.pri)
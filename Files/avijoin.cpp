@@ -0,0 +1,363 @@
+#include "avijoin.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr uint32_t tag(const char (&s)[5]) {
+    return (uint32_t)(uint8_t)s[0] | (uint32_t)(uint8_t)s[1] << 8 | (uint32_t)(uint8_t)s[2] << 16 |
+           (uint32_t)(uint8_t)s[3] << 24;
+}
+
+constexpr uint32_t kAviKeyframe = 0x10;       // AVIIF_KEYFRAME in idx1
+constexpr uint32_t kAviHasIndex = 0x10;       // AVIF_HASINDEX in avih
+constexpr uint64_t kRiffLimit = 0xFFFFFFF0u;  // RIFF sizes are 32-bit
+
+uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+void appendU32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[4];
+    putU32(b, v);
+    out.insert(out.end(), b, b + 4);
+}
+
+void appendChunk(std::vector<uint8_t>& out, uint32_t id, const std::vector<uint8_t>& payload) {
+    appendU32(out, id);
+    appendU32(out, (uint32_t)payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+    if (payload.size() & 1) out.push_back(0);
+}
+
+bool readU32(std::istream& in, uint32_t& v) {
+    uint8_t b[4];
+    if (!in.read(reinterpret_cast<char*>(b), 4)) return false;
+    v = getU32(b);
+    return true;
+}
+
+bool readBytes(std::istream& in, uint64_t pos, uint32_t size, std::vector<uint8_t>& out) {
+    out.resize(size);
+    in.seekg((std::streamoff)pos);
+    return size == 0 || (bool)in.read(reinterpret_cast<char*>(out.data()), size);
+}
+
+// Video stream 00 frame chunk: "00dc" (compressed) or "00db" (uncompressed)
+bool isVideoChunk(uint32_t id) {
+    return id == tag("00dc") || id == tag("00db");
+}
+
+struct Frame {
+    uint32_t id;
+    uint32_t size;
+    uint64_t offset;   // payload position in the part
+    uint32_t flags;    // from idx1
+};
+
+struct Part {
+    std::vector<uint8_t> avih;   // payloads, patched when the output is written
+    std::vector<uint8_t> strh;
+    std::vector<uint8_t> strf;
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> strlExtra;  // strd, strn, vprp ...
+    std::vector<Frame> frames;
+};
+
+// The hdrl list: avih plus one strl, keeping what the output needs
+bool parseHeaderList(const std::vector<uint8_t>& hdrl, Part& part) {
+    int streams = 0;
+    for (size_t pos = 0; pos + 8 <= hdrl.size();) {
+        uint32_t id = getU32(&hdrl[pos]);
+        uint32_t size = getU32(&hdrl[pos + 4]);
+        size_t data = pos + 8;
+        if (size > hdrl.size() - data) return false;
+        if (id == tag("avih")) {
+            part.avih.assign(hdrl.begin() + data, hdrl.begin() + data + size);
+        } else if (id == tag("LIST") && size >= 4 && getU32(&hdrl[data]) == tag("strl")) {
+            if (++streams > 1) return false;
+            for (size_t s = data + 4; s + 8 <= data + size;) {
+                uint32_t sid = getU32(&hdrl[s]);
+                uint32_t ssize = getU32(&hdrl[s + 4]);
+                if (ssize > data + size - (s + 8)) return false;
+                std::vector<uint8_t> payload(hdrl.begin() + s + 8, hdrl.begin() + s + 8 + ssize);
+                if (sid == tag("strh")) part.strh = std::move(payload);
+                else if (sid == tag("strf")) part.strf = std::move(payload);
+                else if (sid != tag("indx") && sid != tag("JUNK")) part.strlExtra.emplace_back(sid, std::move(payload));
+                s += 8 + ssize + (ssize & 1);
+            }
+        }
+        // LIST odml and JUNK are dropped
+        pos = data + size + (size & 1);
+    }
+    return streams == 1 && part.avih.size() >= 40 && part.strh.size() >= 40 && !part.strf.empty() &&
+           getU32(part.strh.data()) == tag("vids");
+}
+
+// Frame chunks of a movi list, descending into "rec " groups; index chunks and padding are skipped
+bool parseMovi(std::istream& in, uint64_t pos, uint64_t end, Part& part) {
+    while (pos + 8 <= end) {
+        uint32_t id, size;
+        in.seekg((std::streamoff)pos);
+        if (!readU32(in, id) || !readU32(in, size) || size > end - pos - 8) return false;
+        if (id == tag("LIST")) {
+            uint32_t type;
+            if (size < 4 || !readU32(in, type) || type != tag("rec ")) return false;
+            if (!parseMovi(in, pos + 12, pos + 8 + size, part)) return false;
+        } else if (isVideoChunk(id)) {
+            part.frames.push_back({id, size, pos + 8, 0});
+        } else if (id != tag("JUNK") && (id & 0xFFFF) != (tag("ix00") & 0xFFFF)) {
+            return false; // another stream
+        }
+        pos += 8 + (uint64_t)size + (size & 1);
+    }
+    return true;
+}
+
+bool parsePart(const std::string& path, Part& part) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    uint32_t riff, riffSize, form;
+    if (!readU32(in, riff) || !readU32(in, riffSize) || !readU32(in, form) || riff != tag("RIFF") ||
+        form != tag("AVI ") || 8 + (uint64_t)riffSize > fileSize)
+        return false;
+    // A second RIFF ("AVIX") means an OpenDML file whose frames idx1 does not cover
+    uint64_t end = 8 + (uint64_t)riffSize;
+    if (fileSize > end + (end & 1) + 8) return false;
+
+    std::vector<uint32_t> flags;
+    bool haveHeaders = false, haveIndex = false;
+    for (uint64_t pos = 12; pos + 8 <= end;) {
+        uint32_t id, size;
+        in.seekg((std::streamoff)pos);
+        if (!readU32(in, id) || !readU32(in, size) || size > end - pos - 8) return false;
+        if (id == tag("LIST") && size >= 4) {
+            uint32_t type;
+            if (!readU32(in, type)) return false;
+            if (type == tag("hdrl")) {
+                std::vector<uint8_t> hdrl;
+                if (!readBytes(in, pos + 12, size - 4, hdrl) || !parseHeaderList(hdrl, part)) return false;
+                haveHeaders = true;
+            } else if (type == tag("movi")) {
+                if (!parseMovi(in, pos + 12, pos + 8 + size, part)) return false;
+            }
+        } else if (id == tag("idx1")) {
+            std::vector<uint8_t> index;
+            if (!readBytes(in, pos + 8, size, index)) return false;
+            for (size_t e = 0; e + 16 <= index.size(); e += 16)
+                if (isVideoChunk(getU32(&index[e]))) flags.push_back(getU32(&index[e + 4]));
+            haveIndex = true;
+        }
+        pos += 8 + (uint64_t)size + (size & 1);
+    }
+    if (!haveHeaders || !haveIndex || flags.size() != part.frames.size()) return false;
+    for (size_t i = 0; i < flags.size(); ++i) part.frames[i].flags = flags[i];
+    return true;
+}
+
+// RIFF header, hdrl and the movi list header of a plain AVI 1.0 holding frameCount
+// frames in moviSize bytes, with the headers' totals patched; empty past the RIFF limit
+std::vector<uint8_t> fileHeader(Part& headers, uint64_t frameCount, uint32_t largest, uint64_t moviSize) {
+    putU32(&headers.avih[12], getU32(&headers.avih[12]) | kAviHasIndex);
+    putU32(&headers.avih[16], (uint32_t)frameCount);
+    putU32(&headers.avih[28], largest);
+    putU32(&headers.strh[32], (uint32_t)frameCount);
+    putU32(&headers.strh[36], largest);
+
+    std::vector<uint8_t> strl;
+    appendU32(strl, tag("strl"));
+    appendChunk(strl, tag("strh"), headers.strh);
+    appendChunk(strl, tag("strf"), headers.strf);
+    for (const auto& extra : headers.strlExtra) appendChunk(strl, extra.first, extra.second);
+    std::vector<uint8_t> hdrl;
+    appendU32(hdrl, tag("hdrl"));
+    appendChunk(hdrl, tag("avih"), headers.avih);
+    appendChunk(hdrl, tag("LIST"), strl);
+
+    std::vector<uint8_t> head;
+    uint64_t riffSize = 4 + (8 + hdrl.size()) + (8 + moviSize) + (8 + frameCount * 16);
+    if (riffSize > kRiffLimit) return head;
+    appendU32(head, tag("RIFF"));
+    appendU32(head, (uint32_t)riffSize);
+    appendU32(head, tag("AVI "));
+    appendChunk(head, tag("LIST"), hdrl);
+    appendU32(head, tag("LIST"));
+    appendU32(head, (uint32_t)moviSize);
+    appendU32(head, tag("movi"));
+    return head;
+}
+
+void appendIndexEntry(std::vector<uint8_t>& index, uint32_t id, uint32_t flags, uint32_t offset, uint32_t size) {
+    appendU32(index, id);
+    appendU32(index, flags);
+    appendU32(index, offset);
+    appendU32(index, size);
+}
+
+// Headers of a single video stream of independently coded frames
+Part intraHeaders(const char* fourcc, int width, int height, double fps) {
+    uint32_t handler = getU32(reinterpret_cast<const uint8_t*>(fourcc));
+    // Frame rate as rate / scale, exact for integer and NTSC (x/1.001) rates
+    uint32_t scale = 1001, rate = (uint32_t)std::lround(fps * scale);
+    Part part;
+    part.avih.assign(56, 0);
+    putU32(&part.avih[0], (uint32_t)std::lround(1e6 / fps));  // microseconds per frame
+    putU32(&part.avih[24], 1);                                // streams
+    putU32(&part.avih[32], (uint32_t)width);
+    putU32(&part.avih[36], (uint32_t)height);
+
+    part.strh.assign(56, 0);
+    putU32(&part.strh[0], tag("vids"));
+    putU32(&part.strh[4], handler);
+    putU32(&part.strh[20], scale);
+    putU32(&part.strh[24], rate);
+    putU32(&part.strh[40], 0xFFFFFFFFu);  // quality: default
+    putU32(&part.strh[52], (uint32_t)(width & 0xFFFF) | (uint32_t)height << 16);  // rcFrame right, bottom
+
+    part.strf.assign(40, 0);  // BITMAPINFOHEADER
+    putU32(&part.strf[0], 40);
+    putU32(&part.strf[4], (uint32_t)width);
+    putU32(&part.strf[8], (uint32_t)height);
+    putU32(&part.strf[12], 1 | 24 << 16);  // planes, bits per pixel
+    putU32(&part.strf[16], handler);
+    putU32(&part.strf[20], (uint32_t)width * (uint32_t)height * 3);
+    return part;
+}
+
+} // namespace
+
+namespace AviJoin {
+
+bool concatenate(const std::vector<std::string>& parts, const std::string& outputPath) {
+    if (parts.empty()) return false;
+    std::vector<Part> parsed(parts.size());
+    uint64_t frameCount = 0, moviSize = 4;
+    uint32_t largest = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (!parsePart(parts[i], parsed[i])) return false;
+        // Same codec, frame size and codec private data, or the frames would not decode as one stream
+        if (parsed[i].strf != parsed[0].strf || getU32(&parsed[i].strh[4]) != getU32(&parsed[0].strh[4])) return false;
+        for (const Frame& f : parsed[i].frames) {
+            moviSize += 8 + (uint64_t)f.size + (f.size & 1);
+            largest = std::max(largest, f.size);
+        }
+        frameCount += parsed[i].frames.size();
+    }
+
+    // Headers: the first part's, with totals for the whole file
+    std::vector<uint8_t> head = fileHeader(parsed[0], frameCount, largest, moviSize);
+    if (head.empty()) return false;
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.write(reinterpret_cast<const char*>(head.data()), (std::streamsize)head.size())) return false;
+
+    // Frames in order; idx1 offsets count from the "movi" tag
+    std::vector<uint8_t> index;
+    index.reserve((size_t)frameCount * 16 + 8);
+    appendU32(index, tag("idx1"));
+    appendU32(index, (uint32_t)(frameCount * 16));
+    std::vector<char> buffer(1 << 20);
+    uint32_t offset = 4;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        std::ifstream in(parts[i], std::ios::binary);
+        if (!in) return false;
+        for (const Frame& f : parsed[i].frames) {
+            uint8_t header[8];
+            putU32(header, f.id);
+            putU32(header + 4, f.size);
+            out.write(reinterpret_cast<const char*>(header), 8);
+            in.seekg((std::streamoff)f.offset);
+            for (uint32_t left = f.size; left > 0;) {
+                uint32_t n = std::min<uint32_t>(left, (uint32_t)buffer.size());
+                if (!in.read(buffer.data(), n) || !out.write(buffer.data(), n)) return false;
+                left -= n;
+            }
+            if (f.size & 1) out.put(0);
+
+            appendIndexEntry(index, f.id, f.flags & kAviKeyframe ? kAviKeyframe : 0, offset, f.size);
+            offset += 8 + f.size + (f.size & 1);
+        }
+    }
+    out.write(reinterpret_cast<const char*>(index.data()), (std::streamsize)index.size());
+    return (bool)out.flush();
+}
+
+bool FrameWriter::open(const std::string& path, const char* fourcc, int width, int height, double fps) {
+    close();
+    if (width <= 0 || height <= 0 || fps <= 0) return false;
+    std::memcpy(handler, fourcc, 4);
+    this->width = width;
+    this->height = height;
+    this->fps = fps;
+    frames = 0;
+    moviSize = 4;
+    largest = 0;
+    index.clear();
+    appendU32(index, tag("idx1"));
+    appendU32(index, 0);
+
+    // Placeholder header of the final size, rewritten with the totals by close()
+    Part headers = intraHeaders(handler, width, height, fps);
+    std::vector<uint8_t> head = fileHeader(headers, 0, 0, moviSize);
+    headerSize = head.size();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (out.write(reinterpret_cast<const char*>(head.data()), (std::streamsize)head.size())) return true;
+    out.close();
+    return false;
+}
+
+bool FrameWriter::write(const uint8_t* data, size_t size) {
+    return size > 0 && append(data, size, kAviKeyframe);
+}
+
+bool FrameWriter::writeRepeat() {
+    return frames > 0 && append(nullptr, 0, 0);
+}
+
+bool FrameWriter::append(const uint8_t* data, size_t size, uint32_t flags) {
+    if (!out.is_open()) return false;
+    // RIFF size with this frame: hdrl and list headers, the movi payload and idx1
+    uint64_t grown = 8 + (uint64_t)size + (size & 1);
+    if (headerSize - 12 + moviSize + grown + index.size() + 16 > kRiffLimit) return false;
+
+    uint8_t header[8];
+    putU32(header, tag("00dc"));
+    putU32(header + 4, (uint32_t)size);
+    out.write(reinterpret_cast<const char*>(header), 8);
+    if (size > 0) out.write(reinterpret_cast<const char*>(data), (std::streamsize)size);
+    if (size & 1) out.put(0);
+    if (!out) return false;
+
+    appendIndexEntry(index, tag("00dc"), flags, (uint32_t)moviSize, (uint32_t)size);
+    moviSize += grown;
+    largest = std::max(largest, (uint32_t)size);
+    ++frames;
+    return true;
+}
+
+bool FrameWriter::close() {
+    if (!out.is_open()) return false;
+    putU32(&index[4], (uint32_t)(index.size() - 8));
+    out.write(reinterpret_cast<const char*>(index.data()), (std::streamsize)index.size());
+
+    Part headers = intraHeaders(handler, width, height, fps);
+    std::vector<uint8_t> head = fileHeader(headers, frames, largest, moviSize);
+    out.seekp(0);
+    if (!head.empty()) out.write(reinterpret_cast<const char*>(head.data()), (std::streamsize)head.size());
+    bool ok = !head.empty() && (bool)out.flush();
+    out.close();
+    return ok;
+}
+
+
+} // namespace AviJoin
@@ -0,0 +1,64 @@
+#ifndef AVIJOIN_H
+#define AVIJOIN_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+  AVI JOIN - lossless concatenation of AVI files written by the same encoder settings
+  (the segments of a segment-parallel video job):
+  - Each part is walked as RIFF chunks: the header list (hdrl), the frame chunks of
+    video stream 00 inside the movi list, and the idx1 index for the keyframe flags;
+    OpenDML extras (indx / ix## indexes, odml, JUNK padding) are dropped
+  - The output is a plain AVI 1.0: the first part's headers with the frame count and
+    buffer size patched, one movi list holding every part's frames in order, and an
+    idx1 rebuilt from the collected (id, flags, size) entries; frame data is copied
+    through a fixed buffer, never decoded
+  - Refuses what it cannot splice safely: extra streams, parts without idx1, parts
+    spanning several RIFFs (> 1 GB OpenDML), headers that differ, or an output past
+    the 4 GB RIFF limit
+  - FrameWriter writes the same layout from frames coded elsewhere (the JPEGs of the
+    frame-parallel MJPEG mode): chunks are streamed to disk as they arrive, the idx1
+    entries collect in memory (16 bytes a frame), and close() appends the index and
+    rewrites the fixed-size header with the totals. A repeated frame is an empty chunk
+    (not a keyframe), which players show as the previous frame held for one more tick
+*/
+
+namespace AviJoin {
+
+// Writes parts[0] + parts[1] + ... to outputPath; false (and no usable output) when a
+// part cannot be read or spliced
+bool concatenate(const std::vector<std::string>& parts, const std::string& outputPath);
+
+// One video stream of intra-coded frames (every stored frame a keyframe), e.g. fourcc "MJPG"
+class FrameWriter {
+public:
+    ~FrameWriter() { close(); }
+    bool open(const std::string& path, const char* fourcc, int width, int height, double fps);
+    bool isOpened() const { return out.is_open(); }
+    // One coded frame, in display order; false on a write error or when the file would
+    // pass the 4 GB RIFF limit (the frame is not written)
+    bool write(const uint8_t* data, size_t size);
+    // The previous frame again, as an empty chunk; false before the first frame
+    bool writeRepeat();
+    // Writes the index and the final headers; the file is unusable if this fails
+    bool close();
+
+private:
+    bool append(const uint8_t* data, size_t size, uint32_t flags);
+
+    std::ofstream out;
+    char handler[4] = {};
+    int width = 0, height = 0;
+    double fps = 0;
+    uint32_t frames = 0, largest = 0;
+    uint64_t moviSize = 0;        // from the "movi" tag, which idx1 offsets count from
+    uint64_t headerSize = 0;      // RIFF header through the "movi" tag
+    std::vector<uint8_t> index;   // idx1 chunk, header included
+};
+
+} // namespace AviJoin
+
+#endif // AVIJOIN_H
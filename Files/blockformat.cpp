@@ -0,0 +1,307 @@
+#include "blockformat.h"
+#include "checksum.h"
+#include "parallel.h"
+#include <numeric>
+
+namespace BlockFormat {
+
+// --- Tagged-block container constants ---
+// A type with kBlockChecked set is followed by the CRC-32C of the raw block; the
+// kBlockEndChecked end mark by the file checksum (see chainCrc)
+enum : uint8_t { kBlockChecked = 0x80, kBlockEndChecked = 0xFE, kBlockEnd = 0xFF };
+static constexpr size_t kFileHeaderSize = 8; // magic + block size
+static constexpr size_t kFooterSize = 8;
+
+uint32_t chainCrc(uint32_t fileCrc, uint32_t blockCrc) {
+    uint8_t bytes[4] = { (uint8_t)blockCrc, (uint8_t)(blockCrc >> 8), (uint8_t)(blockCrc >> 16),
+                         (uint8_t)(blockCrc >> 24) };
+    return Checksum::crc32c(bytes, 4, fileCrc);
+}
+
+size_t readFully(Huffman::InputStream& in, uint8_t* buf, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        size_t n = in.read(buf + got, size - got);
+        if (n == 0) break;
+        got += n;
+    }
+    return got;
+}
+
+static void writeFileHeader(const Codec& codec, std::vector<uint8_t>& out, size_t blockSize) {
+    out.insert(out.end(), codec.magic, codec.magic + 4);
+    writeUint32(out, (uint32_t)blockSize);
+}
+
+static void writeBlock(std::vector<uint8_t>& out, const EncodedBlock& block, size_t raw, bool checked) {
+    out.push_back(checked ? (uint8_t)(block.type | kBlockChecked) : block.type);
+    writeUint32(out, (uint32_t)raw);
+    writeUint32(out, (uint32_t)block.payload.size());
+    if (checked) writeUint32(out, block.crc);
+    out.insert(out.end(), block.payload.begin(), block.payload.end());
+}
+
+static void writeTrailer(std::vector<uint8_t>& out, uint64_t originalSize, bool checked, uint32_t fileCrc) {
+    out.push_back(checked ? kBlockEndChecked : kBlockEnd);
+    if (checked) writeUint32(out, fileCrc);
+    writeUint64(out, originalSize);
+}
+
+bool hasMagic(const Codec& codec, const uint8_t* in, size_t size) {
+    return in && size >= 4 && std::memcmp(in, codec.magic, 4) == 0;
+}
+
+bool compressBytes(const Codec& codec, const BlockEncoder& encode, const uint8_t* input, size_t size,
+                   std::vector<uint8_t>& outBinary, const Huffman::Options& options) {
+    if (!input || size == 0) return false;
+    outBinary.clear();
+    size_t blockSize = clampBlockSize(options.blockSize);
+    size_t count = (size + blockSize - 1) / blockSize;
+
+    ProgressTracker progress(options.progress, size);
+    std::vector<EncodedBlock> blocks(count);
+    std::atomic<bool> ok(true);
+    Parallel::forEach(count, options.threads, [&](size_t i) {
+        if (!ok) return; // cancelled: skip the remaining blocks
+        size_t len = std::min(blockSize, size - i * blockSize);
+        encode(input + i * blockSize, len, blocks[i]);
+        if (options.checksums) blocks[i].crc = Checksum::crc32c(input + i * blockSize, len);
+        if (!progress.advance(len)) ok = false;
+    });
+    if (!ok) return false;
+
+    size_t checkBytes = options.checksums ? kChecksumSize : 0;
+    size_t total = kFileHeaderSize + 1 + checkBytes + kFooterSize;
+    for (const auto& b : blocks) total += kBlockHeaderSize + checkBytes + b.payload.size();
+    outBinary.reserve(total);
+    writeFileHeader(codec, outBinary, blockSize);
+    uint32_t fileCrc = 0;
+    for (size_t i = 0; i < count; ++i) {
+        writeBlock(outBinary, blocks[i], std::min(blockSize, size - i * blockSize), options.checksums);
+        fileCrc = chainCrc(fileCrc, blocks[i].crc);
+        std::vector<uint8_t>().swap(blocks[i].payload);
+    }
+    writeTrailer(outBinary, size, options.checksums, fileCrc);
+    return true;
+}
+
+bool decompressedSize(const Codec& codec, const uint8_t* in, size_t size, uint64_t& outSize) {
+    if (!hasMagic(codec, in, size) || size < kFileHeaderSize + 1 + kFooterSize) return false;
+    size_t pos = 4;
+    uint64_t blockSize = readUint32(in, pos);
+    if (blockSize < kMinBlockSize || blockSize > kMaxBlockSize) return false;
+    pos = size - kFooterSize;
+    outSize = readUint64(in, pos);
+    // At most one full block per block header
+    return outSize <= (uint64_t)(size / kBlockHeaderSize + 1) * blockSize;
+}
+
+// Hops over the block headers to find every payload (the container's seek index,
+// built without decoding); all blocks but the last are full, so block i decodes
+// to i * blockSize
+static bool readBlockOffsets(const uint8_t* in, size_t size, uint64_t originalSize, size_t& blockSize,
+                             std::vector<size_t>& offsets) {
+    size_t pos = 4;
+    blockSize = readUint32(in, pos);
+    if (blockSize < kMinBlockSize || blockSize > kMaxBlockSize) return false;
+
+    uint64_t total = 0;
+    uint32_t fileCrc = 0;
+    size_t end = size - kFooterSize;
+    for (;;) {
+        if (pos >= end) return false;
+        if (in[pos] == kBlockEnd) { pos++; break; }
+        if (in[pos] == kBlockEndChecked) {
+            // The block CRCs chained in order must give the file checksum
+            pos++;
+            if (end - pos < kChecksumSize || readUint32(in, pos) != fileCrc) return false;
+            break;
+        }
+        bool checked = (in[pos] & kBlockChecked) != 0;
+        size_t header = kBlockHeaderSize + (checked ? kChecksumSize : 0);
+        if (header > end - pos) return false;
+        size_t bpos = pos + 1;
+        size_t raw = readUint32(in, bpos);
+        size_t payload = readUint32(in, bpos);
+        if (checked) fileCrc = chainCrc(fileCrc, readUint32(in, bpos));
+        if (raw == 0 || raw > blockSize || payload > end - bpos) return false;
+        if (total % blockSize != 0) return false; // a short block before this one
+        offsets.push_back(pos);
+        total += raw;
+        pos = bpos + payload;
+    }
+    return pos == end && total == originalSize;
+}
+
+// Decodes blocks [first, last) on the worker pool and checks their CRCs when the
+// file has them; out receives block `first`, or nothing when null (verify: each
+// worker decodes into a scratch block of its own)
+static bool decodeBlocks(const Codec& codec, const uint8_t* in, const std::vector<size_t>& offsets,
+                         size_t blockSize, size_t first, size_t last, int threads, uint8_t* out,
+                         ProgressTracker& progress) {
+    std::atomic<bool> ok(true);
+    Parallel::forEach(last - first, threads, [&](size_t k) {
+        if (!ok) return;
+        thread_local std::vector<uint8_t> scratch;
+        size_t bpos = offsets[first + k];
+        uint8_t type = in[bpos++];
+        size_t raw = readUint32(in, bpos);
+        size_t payload = readUint32(in, bpos);
+        bool checked = (type & kBlockChecked) != 0;
+        uint32_t crc = checked ? readUint32(in, bpos) : 0;
+        if (!out && scratch.size() < raw) scratch.resize(raw);
+        uint8_t* dst = out ? out + k * blockSize : scratch.data();
+        if (!codec.decodeBlock((uint8_t)(type & ~kBlockChecked), in + bpos, payload, dst, raw) ||
+            (checked && Checksum::crc32c(dst, raw) != crc) || !progress.advance(raw)) ok = false;
+    });
+    return ok;
+}
+
+bool decompressTo(const Codec& codec, const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads,
+                  Huffman::Progress* sink) {
+    uint64_t originalSize = 0;
+    size_t blockSize = 0;
+    std::vector<size_t> offsets;
+    if (!decompressedSize(codec, in, size, originalSize) || originalSize != outSize || (!out && outSize) ||
+        !readBlockOffsets(in, size, originalSize, blockSize, offsets)) return false;
+    ProgressTracker progress(sink, originalSize);
+    return decodeBlocks(codec, in, offsets, blockSize, 0, offsets.size(), threads, out, progress);
+}
+
+bool decompressRange(const Codec& codec, const uint8_t* in, size_t size, uint64_t offset, size_t length,
+                     std::vector<uint8_t>& out, int threads) {
+    uint64_t originalSize = 0;
+    size_t blockSize = 0;
+    std::vector<size_t> offsets;
+    if (!decompressedSize(codec, in, size, originalSize) || offset > originalSize ||
+        !readBlockOffsets(in, size, originalSize, blockSize, offsets)) return false;
+    length = (size_t)std::min<uint64_t>(length, originalSize - offset);
+    out.clear();
+    if (length == 0) return true;
+
+    // Only the blocks covering the range are decoded
+    size_t first = (size_t)(offset / blockSize);
+    size_t last = (size_t)((offset + length - 1) / blockSize) + 1;
+    uint64_t begin = (uint64_t)first * blockSize;
+    std::vector<uint8_t> blocks((size_t)(std::min<uint64_t>(originalSize, (uint64_t)last * blockSize) - begin));
+    ProgressTracker progress(nullptr, blocks.size());
+    if (!decodeBlocks(codec, in, offsets, blockSize, first, last, threads, blocks.data(), progress)) return false;
+    out.assign(blocks.begin() + (size_t)(offset - begin), blocks.begin() + (size_t)(offset - begin) + length);
+    return true;
+}
+
+bool verify(const Codec& codec, const uint8_t* in, size_t size, int threads, Huffman::Progress* sink) {
+    uint64_t originalSize = 0;
+    size_t blockSize = 0;
+    std::vector<size_t> offsets;
+    if (!decompressedSize(codec, in, size, originalSize) ||
+        !readBlockOffsets(in, size, originalSize, blockSize, offsets)) return false;
+    ProgressTracker progress(sink, originalSize);
+    return decodeBlocks(codec, in, offsets, blockSize, 0, offsets.size(), threads, nullptr, progress);
+}
+
+bool decompressBytes(const Codec& codec, const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes,
+                     int threads, Huffman::Progress* progress) {
+    uint64_t originalSize = 0;
+    if (!decompressedSize(codec, in, size, originalSize)) return false;
+    outBytes.clear();
+    outBytes.resize((size_t)originalSize);
+    return decompressTo(codec, in, size, outBytes.data(), outBytes.size(), threads, progress);
+}
+
+// --- Streaming API ---
+// Up to `threads` blocks are coded at a time and written as they finish
+bool compressStream(const Codec& codec, const BlockEncoder& encode, Huffman::InputStream& in,
+                    Huffman::OutputStream& out, const Huffman::Options& options) {
+    size_t blockSize = clampBlockSize(options.blockSize);
+    size_t batch = (size_t)(options.threads > 0 ? options.threads : Parallel::defaultThreads());
+    std::vector<std::vector<uint8_t>> raw(batch, std::vector<uint8_t>(blockSize));
+    std::vector<EncodedBlock> blocks(batch);
+    std::vector<size_t> sizes(batch);
+
+    std::vector<uint8_t> head;
+    writeFileHeader(codec, head, blockSize);
+    if (!out.write(head.data(), head.size())) return false;
+
+    uint64_t total = 0;
+    uint32_t fileCrc = 0;
+    bool eof = false;
+    ProgressTracker progress(options.progress, 0); // size unknown until the input ends
+    while (!eof) {
+        size_t k = 0;
+        while (k < batch && !eof) {
+            sizes[k] = readFully(in, raw[k].data(), blockSize);
+            eof = sizes[k] < blockSize;
+            if (sizes[k] > 0) ++k;
+        }
+        Parallel::forEach(k, options.threads, [&](size_t i) {
+            encode(raw[i].data(), sizes[i], blocks[i]);
+            if (options.checksums) blocks[i].crc = Checksum::crc32c(raw[i].data(), sizes[i]);
+        });
+        for (size_t i = 0; i < k; ++i) {
+            head.clear();
+            writeBlock(head, blocks[i], sizes[i], options.checksums);
+            if (!out.write(head.data(), head.size())) return false;
+            fileCrc = chainCrc(fileCrc, blocks[i].crc);
+            total += sizes[i];
+        }
+        if (!progress.advance(std::accumulate(sizes.begin(), sizes.begin() + k, (uint64_t)0))) return false;
+    }
+    if (total == 0) return false;
+    head.clear();
+    writeTrailer(head, total, options.checksums, fileCrc);
+    return out.write(head.data(), head.size());
+}
+
+bool decompressStream(const Codec& codec, Huffman::InputStream& in, Huffman::OutputStream& out,
+                      Huffman::Progress* sink) {
+    uint8_t head[kFileHeaderSize];
+    if (readFully(in, head, kFileHeaderSize) != kFileHeaderSize || !hasMagic(codec, head, kFileHeaderSize))
+        return false;
+    size_t pos = 4;
+    size_t blockSize = readUint32(head, pos);
+    if (blockSize < kMinBlockSize || blockSize > kMaxBlockSize) return false;
+
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> block(blockSize);
+    uint64_t total = 0;
+    uint32_t fileCrc = 0;
+    bool shortBlock = false;
+    ProgressTracker progress(sink, 0); // the original size sits in the footer
+    for (;;) {
+        uint8_t bh[kBlockHeaderSize + kChecksumSize];
+        if (readFully(in, bh, 1) != 1) return false;
+        if (bh[0] == kBlockEnd) break;
+        if (bh[0] == kBlockEndChecked) {
+            size_t cpos = 0;
+            if (readFully(in, bh, kChecksumSize) != kChecksumSize || readUint32(bh, cpos) != fileCrc) return false;
+            break;
+        }
+        bool checked = (bh[0] & kBlockChecked) != 0;
+        size_t rest = kBlockHeaderSize - 1 + (checked ? kChecksumSize : 0);
+        if (readFully(in, bh + 1, rest) != rest) return false;
+        size_t bpos = 1;
+        size_t raw = readUint32(bh, bpos);
+        size_t size = readUint32(bh, bpos);
+        uint32_t crc = checked ? readUint32(bh, bpos) : 0;
+        // the payload bound keeps a corrupt header from allocating gigabytes
+        if (raw == 0 || raw > blockSize || size > blockSize + codec.payloadSlack || shortBlock) return false;
+        shortBlock = raw < blockSize;
+        payload.resize(size);
+        if (readFully(in, payload.data(), size) != size) return false;
+        if (!codec.decodeBlock((uint8_t)(bh[0] & ~kBlockChecked), payload.data(), size, block.data(), raw))
+            return false;
+        if (checked) {
+            if (Checksum::crc32c(block.data(), raw) != crc) return false;
+            fileCrc = chainCrc(fileCrc, crc);
+        }
+        if (!out.write(block.data(), raw) || !progress.advance(raw)) return false;
+        total += raw;
+    }
+    uint8_t footer[kFooterSize];
+    if (readFully(in, footer, kFooterSize) != kFooterSize) return false;
+    pos = 0;
+    return readUint64(footer, pos) == total;
+}
+
+} // namespace BlockFormat
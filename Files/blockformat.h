@@ -0,0 +1,150 @@
+#ifndef BLOCKFORMAT_H
+#define BLOCKFORMAT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "huffman.h"
+
+/*
+  BLOCKFORMAT - internal pieces shared by the three block coders (Huffman, FSE, LZ77):
+  - Little-endian byte helpers, the block size limits, the file checksum chain and the
+    progress tracker every parallel loop reports through
+  - The tagged-block container of FSE1 and LZH1: magic (4) | block size (4) | blocks:
+    type (1) | raw size (4) | payload size (4) | [CRC-32C of the raw block (4), when type
+    bit 7 is set] | payload ... | end 0xFF, or 0xFE + file checksum (4) | original size (8)
+  - A coder plugs in its block encoder and decoder; splitting, the worker pool, the CRCs,
+    the seek index (block headers hopped over, no decoding) and streaming live here once
+  - Blocks are independent and all but the last are full, so block i decodes to
+    i * blockSize: both directions run on the worker pool and a range decodes only the
+    blocks covering it
+*/
+
+namespace BlockFormat {
+
+// --- Helpers for binary read/write in memory (little-endian) ---
+inline void writeUint32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back((uint8_t)(v >> (i * 8)));
+}
+inline uint32_t readUint32(const uint8_t* in, size_t& pos) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= uint32_t(in[pos++]) << (i * 8);
+    return v;
+}
+inline void writeUint64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back((uint8_t)(v >> (i * 8)));
+}
+inline uint64_t readUint64(const uint8_t* in, size_t& pos) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= uint64_t(in[pos++]) << (i * 8);
+    return v;
+}
+
+// Whole-word little-endian load/store for the bit accumulators. memcpy
+// compiles to a single unaligned move; big-endian hosts swap first.
+inline uint64_t loadUint64LE(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline uint32_t loadUint32LE(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline void storeUint64LE(uint8_t* p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    std::memcpy(p, &v, 8);
+}
+
+// --- Block limits shared by all containers ---
+constexpr size_t kMinBlockSize = 64 * 1024;
+constexpr size_t kMaxBlockSize = 64 * 1024 * 1024;
+constexpr size_t kBlockHeaderSize = 9; // type or mode (1) | raw size (4) | payload size (4)
+constexpr size_t kChecksumSize = 4;
+
+inline size_t clampBlockSize(size_t blockSize) {
+    return std::min(std::max(blockSize, kMinBlockSize), kMaxBlockSize);
+}
+
+// The file checksum is the CRC-32C of the block CRCs in order (little-endian), so it
+// is built from what the workers computed without another pass over the data
+uint32_t chainCrc(uint32_t fileCrc, uint32_t blockCrc);
+
+// Shared by all threads of one call: sums the bytes processed, forwards them
+// to the caller's Progress one thread at a time (a busy thread skips its turn
+// rather than wait) and latches cancellation for every thread.
+struct ProgressTracker {
+    Huffman::Progress* sink;
+    uint64_t total;
+    std::atomic<uint64_t> done{0};
+    std::atomic<bool> cancelled{false};
+    std::mutex lock;
+
+    ProgressTracker(Huffman::Progress* p, uint64_t t): sink(p), total(t) {}
+    bool advance(uint64_t n) {
+        if (!sink) return true;
+        done += n;
+        if (cancelled) return false;
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (guard.owns_lock() && !sink->update(done, total)) cancelled = true;
+        return !cancelled;
+    }
+};
+
+// Reads until buf is full or the source is exhausted
+size_t readFully(Huffman::InputStream& in, uint8_t* buf, size_t size);
+
+// --- Tagged-block container (FSE1, LZH1) ---
+// Block types are the coder's own, below 0x80 (bit 7 marks a checked block)
+struct EncodedBlock {
+    uint8_t type = 0; // set by the coder's encoder
+    std::vector<uint8_t> payload;
+    uint32_t crc = 0; // of the raw block, when checksums are on
+};
+
+// Codes src[0, n) into block.type and block.payload; runs on worker threads
+using BlockEncoder = std::function<void(const uint8_t* src, size_t n, EncodedBlock& block)>;
+
+// What tells the coders sharing the container apart
+struct Codec {
+    const char* magic;   // 4 bytes
+    size_t payloadSlack; // a payload may exceed the block size by this much (e.g. a table header)
+    bool (*decodeBlock)(uint8_t type, const uint8_t* payload, size_t size, uint8_t* dst, size_t raw);
+};
+
+bool hasMagic(const Codec& codec, const uint8_t* in, size_t size);
+bool compressBytes(const Codec& codec, const BlockEncoder& encode, const uint8_t* input, size_t size,
+                   std::vector<uint8_t>& outBinary, const Huffman::Options& options);
+// Original size from the footer; fails when it is more than the blocks present can
+// hold (runs and long matches expand without limit), so the result is safe to allocate
+bool decompressedSize(const Codec& codec, const uint8_t* in, size_t size, uint64_t& outSize);
+bool decompressTo(const Codec& codec, const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads,
+                  Huffman::Progress* progress);
+bool decompressRange(const Codec& codec, const uint8_t* in, size_t size, uint64_t offset, size_t length,
+                     std::vector<uint8_t>& out, int threads);
+bool verify(const Codec& codec, const uint8_t* in, size_t size, int threads, Huffman::Progress* progress);
+bool decompressBytes(const Codec& codec, const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes,
+                     int threads, Huffman::Progress* progress);
+bool compressStream(const Codec& codec, const BlockEncoder& encode, Huffman::InputStream& in,
+                    Huffman::OutputStream& out, const Huffman::Options& options);
+bool decompressStream(const Codec& codec, Huffman::InputStream& in, Huffman::OutputStream& out,
+                      Huffman::Progress* progress);
+
+} // namespace BlockFormat
+
+#endif // BLOCKFORMAT_H
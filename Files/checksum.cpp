@@ -0,0 +1,98 @@
+#include "checksum.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CHECKSUM_X86_CRC 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_ARM_CRC 1
+#endif
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82F63B78; // Castagnoli, bit-reversed
+
+struct Tables {
+    uint32_t t[8][256];
+    Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (kPolynomial & (0u - (c & 1)));
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Slicing-by-8 (little-endian loads): one 64-bit word through eight tables per step
+uint32_t crcSoftware(const uint8_t* p, size_t n, uint32_t crc) {
+    const Tables& tb = tables();
+    while (n >= 8) {
+        uint64_t w = load64(p) ^ crc;
+        crc = tb.t[7][w & 0xFF] ^ tb.t[6][(w >> 8) & 0xFF] ^ tb.t[5][(w >> 16) & 0xFF] ^
+              tb.t[4][(w >> 24) & 0xFF] ^ tb.t[3][(w >> 32) & 0xFF] ^ tb.t[2][(w >> 40) & 0xFF] ^
+              tb.t[1][(w >> 48) & 0xFF] ^ tb.t[0][w >> 56];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = (crc >> 8) ^ tb.t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(CHECKSUM_X86_CRC)
+__attribute__((target("sse4.2"))) uint32_t crcHardware(const uint8_t* p, size_t n, uint32_t crc) {
+    uint64_t c = crc;
+    while (n >= 8) {
+        c = _mm_crc32_u64(c, load64(p));
+        p += 8;
+        n -= 8;
+    }
+    uint32_t c32 = (uint32_t)c;
+    while (n--) c32 = _mm_crc32_u8(c32, *p++);
+    return c32;
+}
+
+bool hasHardware() {
+    static const bool yes = __builtin_cpu_supports("sse4.2");
+    return yes;
+}
+#elif defined(CHECKSUM_ARM_CRC)
+uint32_t crcHardware(const uint8_t* p, size_t n, uint32_t crc) {
+    while (n >= 8) {
+        crc = __crc32cd(crc, load64(p));
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = __crc32cb(crc, *p++);
+    return crc;
+}
+
+bool hasHardware() { return true; }
+#endif
+
+} // namespace
+
+namespace Checksum {
+
+uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+#if defined(CHECKSUM_X86_CRC) || defined(CHECKSUM_ARM_CRC)
+    if (hasHardware()) return ~crcHardware(data, size, crc);
+#endif
+    return ~crcSoftware(data, size, crc);
+}
+
+} // namespace Checksum
@@ -0,0 +1,22 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+  CHECKSUM - CRC-32C (Castagnoli) for the block containers' integrity checks:
+  - x86-64: the SSE4.2 crc32 instruction, 8 bytes per step (picked at run time, so the
+    binary still runs on CPUs without it); AArch64 with the CRC extension: __crc32cd
+  - Elsewhere: slicing-by-8, eight 256-entry tables folding 8 bytes per step
+  - Chainable like zlib's crc32(): crc32c(b, nb, crc32c(a, na)) == crc32c(a + b)
+*/
+
+namespace Checksum {
+
+// CRC-32C of data[0, size), continuing from crc (0 to start a new checksum)
+uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+} // namespace Checksum
+
+#endif // CHECKSUM_H
@@ -0,0 +1,13 @@
+# Headless front end: same engine as the GUI, no widgets.
+#   filecompress c|d|bench [options] <paths>
+
+QT = core
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = filecompress
+
+SOURCES += \
+    main.cpp
+
+include(../engine.pri)
@@ -0,0 +1,632 @@
+#include "compressionjob.h"
+#include "fse.h"
+#include "huffman.h"
+#include "imagecom.h"
+#include "lz77.h"
+#include "parallel.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+/*
+  FILECOMPRESS - command-line front end for servers and scripts:
+  - c:     compress files and folders (folders are walked like the GUI's "Select Folder"),
+           on the same bounded worker pool as a GUI batch
+  - d:     decompress .huff files
+  - t:     test .huff files (and folders): decode without writing and check the block and
+           file CRCs, many files side by side on the worker pool
+  - cat:   write bytes [--offset, --offset + --length) of each .huff file's original to
+           stdout as raw bytes (not JSON), decoding only the blocks that cover them
+  - bench: Huffman throughput per file, single-stream HUF2, block-parallel HUFB on
+           1, 2, 4 ... N threads and 4-stream HUFB4 on 1 and N threads, plus the per-call overhead on the first 1 KB, all with
+           a round-trip check; FSE on 1 and N threads and LZ77 + Huffman (LZH) at levels 1, 6, 9
+           for comparison
+  Output is one compact JSON object per line on stdout (one per file or measurement,
+  then a summary); diagnostics go to stderr. Exit codes below.
+*/
+
+namespace {
+
+enum ExitCode {
+    ExitOk = 0,          // every file compressed, skipped (not smaller) or decompressed
+    ExitFailed = 1,      // at least one file failed
+    ExitUsage = 2,       // bad command line, nothing was done
+    ExitCancelled = 130  // interrupted (SIGINT/SIGTERM); partial outputs are removed
+};
+
+// Ctrl+C cancels the running job at its next slice instead of killing the process,
+// so the engine still gets to remove its partial output; files not started yet are
+// reported as cancelled
+std::atomic<JobProgress *> activeJob{nullptr};
+std::atomic<bool> interrupted{false};
+
+void onSignal(int)
+{
+    interrupted = true;
+    if (JobProgress *job = activeJob.load())
+        job->cancel();
+}
+
+void emitLine(const QJsonObject &object)
+{
+    QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+    fflush(stdout);
+}
+
+QString statusName(JobResult::Status status)
+{
+    switch (status) {
+    case JobResult::Succeeded: return QStringLiteral("ok");
+    case JobResult::NotSmaller: return QStringLiteral("skipped");
+    case JobResult::Cancelled: return QStringLiteral("cancelled");
+    default: return QStringLiteral("failed");
+    }
+}
+
+QJsonObject resultObject(const QString &op, const JobResult &result)
+{
+    QJsonObject object;
+    object["op"] = op;
+    object["input"] = result.inputPath;
+    object["status"] = statusName(result.status);
+    if (!result.fileType.isEmpty())
+        object["type"] = result.fileType;
+    if (!result.outPath.isEmpty())
+        object["output"] = result.outPath;
+    object["inputBytes"] = result.inputSize;
+    object["outputBytes"] = result.outputSize;
+    if (result.quality > 0)
+        object["quality"] = result.quality;
+    if (result.status == JobResult::Failed)
+        object["error"] = result.errorSummary();
+    return object;
+}
+
+int exitCodeFor(int failed, int cancelled)
+{
+    if (cancelled > 0)
+        return ExitCancelled;
+    return failed > 0 ? ExitFailed : ExitOk;
+}
+
+// Files named on the command line plus the supported files under any folders
+QStringList expandInputs(const QStringList &args, QStringList &missing)
+{
+    QStringList files;
+    for (const QString &arg : args) {
+        QFileInfo info(arg);
+        if (info.isDir())
+            files += CompressionJob::collectFiles(info.absoluteFilePath());
+        else if (info.isFile())
+            files.append(info.absoluteFilePath());
+        else
+            missing.append(arg);
+    }
+    return files;
+}
+
+// Like expandInputs, but folders contribute their .huff files (recursive)
+QStringList expandArchives(const QStringList &args, QStringList &missing)
+{
+    QStringList files;
+    for (const QString &arg : args) {
+        QFileInfo info(arg);
+        if (info.isDir()) {
+            QStringList found;
+            QDirIterator it(info.absoluteFilePath(), {"*.huff"}, QDir::Files | QDir::Readable,
+                            QDirIterator::Subdirectories);
+            while (it.hasNext())
+                found.append(QFileInfo(it.next()).absoluteFilePath());
+            found.sort();
+            files += found;
+        } else if (info.isFile()) {
+            files.append(info.absoluteFilePath());
+        } else {
+            missing.append(arg);
+        }
+    }
+    return files;
+}
+
+// =============================================================
+// ============================ C / D ============================
+// =============================================================
+int runCompress(const QStringList &args, const QString &outputDir, int workers)
+{
+    QStringList missing;
+    QStringList files = expandInputs(args, missing);
+    for (const QString &path : missing)
+        emitLine({{"op", "compress"}, {"input", path}, {"status", "failed"}, {"error", "No such file or directory"}});
+
+    // A single folder argument keeps its sub-folder layout below -o
+    QString baseDir;
+    if (args.size() == 1 && QFileInfo(args.first()).isDir())
+        baseDir = QFileInfo(args.first()).absoluteFilePath();
+
+    qint64 totalBytes = 0;
+    for (const QString &path : files)
+        totalBytes += QFileInfo(path).size();
+
+    BatchProgress progress;
+    progress.resetBatch(totalBytes, files.size());
+    activeJob = &progress;
+    if (interrupted)
+        progress.cancel();
+    BatchSummary summary = CompressionJob::compressBatch(files, outputDir, baseDir, workers, progress);
+    activeJob = nullptr;
+
+    for (const JobResult &result : summary.results)
+        emitLine(resultObject("compress", result));
+
+    int failed = summary.failed + missing.size();
+    QJsonObject total;
+    total["op"] = "summary";
+    total["files"] = files.size() + missing.size();
+    total["succeeded"] = summary.succeeded;
+    total["skipped"] = summary.skipped;
+    total["failed"] = failed;
+    total["cancelled"] = summary.cancelled;
+    total["inputBytes"] = summary.originalBytes;
+    total["outputBytes"] = summary.compressedBytes;
+    total["elapsedMs"] = summary.elapsedMs;
+    emitLine(total);
+    return exitCodeFor(failed, summary.cancelled);
+}
+
+int runDecompress(const QStringList &args, const QString &outputDir)
+{
+    QElapsedTimer clock;
+    clock.start();
+    int succeeded = 0, failed = 0, cancelled = 0;
+    qint64 inputBytes = 0, outputBytes = 0;
+
+    // One file at a time: HUFB decoding already uses every core
+    for (const QString &arg : args) {
+        QFileInfo info(arg);
+        if (!info.isFile()) {
+            emitLine({{"op", "decompress"}, {"input", arg}, {"status", "failed"}, {"error", "No such file"}});
+            ++failed;
+            continue;
+        }
+        if (interrupted) {
+            emitLine({{"op", "decompress"}, {"input", info.absoluteFilePath()}, {"status", "cancelled"}});
+            ++cancelled;
+            continue;
+        }
+        JobProgress progress;
+        progress.reset(info.size());
+        activeJob = &progress;
+        if (interrupted)
+            progress.cancel();
+        JobResult result = CompressionJob::decompressFile(info.absoluteFilePath(), outputDir, progress);
+        activeJob = nullptr;
+        emitLine(resultObject("decompress", result));
+
+        if (result.status == JobResult::Succeeded) {
+            ++succeeded;
+            inputBytes += result.inputSize;
+            outputBytes += result.outputSize;
+        } else if (result.status == JobResult::Cancelled) {
+            ++cancelled;
+        } else {
+            ++failed;
+        }
+    }
+
+    QJsonObject total;
+    total["op"] = "summary";
+    total["files"] = args.size();
+    total["succeeded"] = succeeded;
+    total["failed"] = failed;
+    total["cancelled"] = cancelled;
+    total["inputBytes"] = inputBytes;
+    total["outputBytes"] = outputBytes;
+    total["elapsedMs"] = clock.elapsed();
+    emitLine(total);
+    return exitCodeFor(failed, cancelled);
+}
+
+// Nightly scrubs cover many archives: with more files than workers each file is checked
+// on one thread and the files run side by side, otherwise each file's blocks are
+// spread over the workers. Lines are emitted as files finish, so their order varies.
+int runVerify(const QStringList &args, int workers)
+{
+    QElapsedTimer clock;
+    clock.start();
+    QStringList missing;
+    QStringList files = expandArchives(args, missing);
+    for (const QString &path : missing)
+        emitLine({{"op", "verify"}, {"input", path}, {"status", "failed"}, {"error", "No such file or directory"}});
+
+    qint64 totalBytes = 0;
+    for (const QString &path : files)
+        totalBytes += QFileInfo(path).size();
+
+    if (workers <= 0)
+        workers = Parallel::defaultThreads();
+    const int engineThreads = files.size() >= workers ? 1 : workers;
+    BatchProgress batch;
+    batch.resetBatch(totalBytes, files.size());
+    activeJob = &batch;
+    if (interrupted)
+        batch.cancel();
+
+    std::mutex lineMutex;
+    std::atomic<int> succeeded{0}, failed{0}, cancelled{0};
+    std::atomic<qint64> inputBytes{0};
+    Parallel::forEach(static_cast<size_t>(files.size()), workers, [&](size_t i) {
+        JobProgress progress;
+        progress.setParent(&batch);
+        JobResult result;
+        if (batch.isCancelled()) {
+            result.inputPath = files[int(i)];
+            result.status = JobResult::Cancelled;
+        } else {
+            result = CompressionJob::verifyFile(files[int(i)], progress, engineThreads);
+        }
+        if (result.status == JobResult::Succeeded) {
+            ++succeeded;
+            inputBytes += result.inputSize;
+        } else if (result.status == JobResult::Cancelled) {
+            ++cancelled;
+        } else {
+            ++failed;
+        }
+        std::lock_guard<std::mutex> lock(lineMutex);
+        emitLine(resultObject("verify", result));
+    });
+    activeJob = nullptr;
+
+    const int failedTotal = failed + int(missing.size());
+    QJsonObject total;
+    total["op"] = "summary";
+    total["files"] = files.size() + missing.size();
+    total["succeeded"] = succeeded.load();
+    total["failed"] = failedTotal;
+    total["cancelled"] = cancelled.load();
+    total["inputBytes"] = inputBytes.load();
+    total["elapsedMs"] = clock.elapsed();
+    emitLine(total);
+    return exitCodeFor(failedTotal, cancelled);
+}
+
+// Raw bytes on stdout, so `filecompress cat log.huff --offset 1048576 --length 4096 | grep ...`
+// works without decompressing the whole file; failures are reported on stderr
+const qint64 kCatPieceBytes = 64 * 1024 * 1024;
+
+int runCat(const QStringList &args, qint64 offset, qint64 length)
+{
+    QTextStream err(stderr);
+    int failed = 0;
+    for (const QString &arg : args) {
+        // In pieces: the default length runs to the end, which may be more than one
+        // QByteArray holds, and only one piece is in memory at a time
+        qint64 position = offset;
+        qint64 remaining = length;
+        while (remaining > 0) {
+            const qint64 piece = std::min(remaining, kCatPieceBytes);
+            QByteArray bytes;
+            if (!CompressionJob::readRange(arg, position, piece, bytes)) {
+                err << "filecompress: cannot read range of " << arg << "\n";
+                ++failed;
+                break;
+            }
+            fwrite(bytes.constData(), 1, static_cast<size_t>(bytes.size()), stdout);
+            if (bytes.size() < piece)
+                break; // reached the end of the original
+            position += piece;
+            remaining -= piece;
+        }
+    }
+    fflush(stdout);
+    return failed > 0 ? ExitFailed : ExitOk;
+}
+
+// =============================================================
+// ============================ BENCH ============================
+// =============================================================
+QString formatName(Huffman::Format format)
+{
+    switch (format) {
+    case Huffman::Format::Legacy: return QStringLiteral("HUF1");
+    case Huffman::Format::Canonical: return QStringLiteral("HUF2");
+    case Huffman::Format::Blocks: return QStringLiteral("HUFB");
+    default: return QStringLiteral("HUFB4");
+    }
+}
+
+enum class Coder { Huffman, Fse, Lz77 };
+
+bool benchCompress(Coder coder, const uint8_t *data, size_t size, std::vector<uint8_t> &packed,
+                   const Lz77::Options &options)
+{
+    switch (coder) {
+    case Coder::Fse: return Fse::compressBytes(data, size, packed, options);
+    case Coder::Lz77: return Lz77::compressBytes(data, size, packed, options);
+    default: return Huffman::compressBytes(data, size, packed, options);
+    }
+}
+
+bool benchDecompress(Coder coder, const std::vector<uint8_t> &packed, uint8_t *out, size_t size, int threads)
+{
+    switch (coder) {
+    case Coder::Fse: return Fse::decompressTo(packed.data(), packed.size(), out, size, threads);
+    case Coder::Lz77: return Lz77::decompressTo(packed.data(), packed.size(), out, size, threads);
+    default: return Huffman::decompressTo(packed.data(), packed.size(), out, size, threads);
+    }
+}
+
+// Best-of-N timing of one configuration; false if the round trip does not match
+bool benchOne(const uint8_t *data, size_t size, Coder coder, const Lz77::Options &options, int repeat,
+              QJsonObject &out)
+{
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> unpacked(size);
+    qint64 bestCompress = -1, bestDecompress = -1;
+
+    for (int r = 0; r < repeat; ++r) {
+        QElapsedTimer clock;
+        clock.start();
+        if (!benchCompress(coder, data, size, packed, options))
+            return false;
+        qint64 ns = clock.nsecsElapsed();
+        if (bestCompress < 0 || ns < bestCompress)
+            bestCompress = ns;
+
+        clock.restart();
+        if (!benchDecompress(coder, packed, unpacked.data(), size, options.threads))
+            return false;
+        ns = clock.nsecsElapsed();
+        if (bestDecompress < 0 || ns < bestDecompress)
+            bestDecompress = ns;
+    }
+    if (size > 0 && memcmp(unpacked.data(), data, size) != 0)
+        return false;
+
+    auto mbps = [size](qint64 ns) { return ns > 0 ? (double)size * 1000.0 / (double)ns : 0.0; };
+    out["compressedBytes"] = (qint64)packed.size();
+    out["ratio"] = size > 0 ? (double)packed.size() / (double)size : 1.0;
+    out["compressMBps"] = mbps(bestCompress);
+    out["decompressMBps"] = mbps(bestDecompress);
+    return true;
+}
+
+// Fixed per-call cost (histogram, tree, tables) on a 1 KB input, the part that
+// dominates batches of many small text files
+bool benchSmall(const uint8_t *data, size_t size, QJsonObject &out)
+{
+    const size_t n = std::min<size_t>(size, 1024);
+    const int calls = 2000;
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> unpacked(n);
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < calls; ++i)
+        if (!Huffman::compressBytes(data, n, packed))
+            return false;
+    qint64 compressNs = clock.nsecsElapsed();
+
+    clock.restart();
+    for (int i = 0; i < calls; ++i)
+        if (!Huffman::decompressTo(packed.data(), packed.size(), unpacked.data(), n, 1))
+            return false;
+    qint64 decompressNs = clock.nsecsElapsed();
+    if (memcmp(unpacked.data(), data, n) != 0)
+        return false;
+
+    out["inputBytes"] = (qint64)n;
+    out["calls"] = calls;
+    out["compressUsPerCall"] = (double)compressNs / 1000.0 / calls;
+    out["decompressUsPerCall"] = (double)decompressNs / 1000.0 / calls;
+    return true;
+}
+
+int runBench(const QStringList &args, int maxThreads, size_t blockSize, int repeat)
+{
+    if (maxThreads <= 0)
+        maxThreads = Parallel::defaultThreads();
+
+    // 1, 2, 4 ... up to and including maxThreads
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    int failed = 0;
+    for (const QString &arg : args) {
+        if (interrupted)
+            return ExitCancelled;
+        QFile file(arg);
+        if (!file.open(QIODevice::ReadOnly)) {
+            emitLine({{"op", "bench"}, {"input", arg}, {"status", "failed"}, {"error", "Cannot open file"}});
+            ++failed;
+            continue;
+        }
+        // Bench from memory so disk speed does not show up in the numbers
+        QByteArray bytes = file.readAll();
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(bytes.constData());
+        size_t size = static_cast<size_t>(bytes.size());
+
+        struct Run { Huffman::Format format; int threads; Coder coder = Coder::Huffman; int level = 0; };
+        std::vector<Run> runs{{Huffman::Format::Canonical, 1}};
+        for (int t : threadCounts)
+            runs.push_back({Huffman::Format::Blocks, t});
+        // 4-stream blocks: per-core gain on one thread, and the full machine
+        runs.push_back({Huffman::Format::Interleaved, 1});
+        if (maxThreads > 1)
+            runs.push_back({Huffman::Format::Interleaved, maxThreads});
+        // tANS blocks, same block size
+        runs.push_back({Huffman::Format::Blocks, 1, Coder::Fse});
+        if (maxThreads > 1)
+            runs.push_back({Huffman::Format::Blocks, maxThreads, Coder::Fse});
+        // LZ77 + Huffman at its fastest, default and smallest levels (own block size)
+        for (int level : {1, 6, 9})
+            runs.push_back({Huffman::Format::Blocks, 1, Coder::Lz77, level});
+        if (maxThreads > 1)
+            runs.push_back({Huffman::Format::Blocks, maxThreads, Coder::Lz77, 6});
+
+        double singleCompress = 0, singleDecompress = 0;
+        for (const Run &run : runs) {
+            if (interrupted)
+                return ExitCancelled;
+            Lz77::Options options;
+            options.format = run.format;
+            options.threads = run.threads;
+            if (run.coder == Coder::Lz77)
+                options.level = run.level;
+            else
+                options.blockSize = blockSize;
+
+            QJsonObject object;
+            object["op"] = "bench";
+            object["input"] = QFileInfo(arg).absoluteFilePath();
+            object["inputBytes"] = (qint64)size;
+            if (run.coder == Coder::Lz77) {
+                object["format"] = QStringLiteral("LZH");
+                object["level"] = run.level;
+            } else {
+                object["format"] = run.coder == Coder::Fse ? QStringLiteral("FSE") : formatName(run.format);
+            }
+            object["threads"] = run.threads;
+            if (!benchOne(data, size, run.coder, options, repeat, object)) {
+                object["status"] = "failed";
+                object["error"] = "Round trip mismatch";
+                emitLine(object);
+                ++failed;
+                continue;
+            }
+            object["status"] = "ok";
+
+            // Speedup against HUFB on one thread, the baseline for scaling
+            if (run.format == Huffman::Format::Blocks && run.coder == Coder::Huffman) {
+                if (run.threads == 1) {
+                    singleCompress = object["compressMBps"].toDouble();
+                    singleDecompress = object["decompressMBps"].toDouble();
+                }
+                if (singleCompress > 0)
+                    object["compressSpeedup"] = object["compressMBps"].toDouble() / singleCompress;
+                if (singleDecompress > 0)
+                    object["decompressSpeedup"] = object["decompressMBps"].toDouble() / singleDecompress;
+            }
+            emitLine(object);
+        }
+
+        if (size > 0) {
+            QJsonObject object;
+            object["op"] = "bench";
+            object["input"] = QFileInfo(arg).absoluteFilePath();
+            object["format"] = "HUF2";
+            object["threads"] = 1;
+            if (benchSmall(data, size, object)) {
+                object["status"] = "ok";
+            } else {
+                object["status"] = "failed";
+                object["error"] = "Round trip mismatch";
+                ++failed;
+            }
+            emitLine(object);
+        }
+    }
+    return failed > 0 ? ExitFailed : ExitOk;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    ImageCompressor::prepareVideoBackend(); // before any thread starts
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("filecompress");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Compress, decompress or benchmark files with the File Compression engine.\n"
+        "Writes one JSON object per line to stdout.\n\n"
+        "Commands:\n"
+        "  c      Compress files and folders (images/videos lossy, text/PDF Huffman)\n"
+        "  d      Decompress .huff files\n"
+        "  t      Test .huff files and folders: decode, check checksums, write nothing\n"
+        "  cat    Write a byte range of .huff files' original content to stdout (raw)\n"
+        "  bench  Huffman throughput on 1..N threads and per-call cost on 1 KB\n\n"
+        "Exit codes: 0 ok, 1 some file failed, 2 usage error, 130 interrupted");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "c, d, t, cat or bench");
+    parser.addPositionalArgument("paths", "Files (and folders for c and t)", "<paths...>");
+    QCommandLineOption outputOption({"o", "output"}, "Output folder (default: next to each input).", "dir");
+    QCommandLineOption threadsOption({"j", "threads"}, "Worker threads; for bench the largest count measured (default: one per core).", "n", "0");
+    QCommandLineOption blockOption("block", "bench: HUFB block size in KB (default 1024).", "kb", "1024");
+    QCommandLineOption repeatOption("repeat", "bench: runs per configuration, best is kept (default 3).", "n", "3");
+    QCommandLineOption offsetOption("offset", "cat: first byte of the range (default 0).", "bytes", "0");
+    QCommandLineOption lengthOption("length", "cat: bytes in the range (default: to the end).", "bytes", "-1");
+    parser.addOptions({outputOption, threadsOption, blockOption, repeatOption, offsetOption, lengthOption});
+    parser.process(app);
+
+    QTextStream err(stderr);
+    QStringList positional = parser.positionalArguments();
+    if (positional.size() < 2) {
+        err << parser.helpText();
+        return ExitUsage;
+    }
+    QString command = positional.takeFirst();
+
+    bool okThreads = false, okBlock = false, okRepeat = false;
+    int threads = parser.value(threadsOption).toInt(&okThreads);
+    int blockKb = parser.value(blockOption).toInt(&okBlock);
+    int repeat = parser.value(repeatOption).toInt(&okRepeat);
+    if (!okThreads || threads < 0 || !okBlock || blockKb <= 0 || !okRepeat || repeat <= 0) {
+        err << "filecompress: -j, --block and --repeat take positive numbers\n";
+        return ExitUsage;
+    }
+
+    bool okOffset = false, okLength = false;
+    qint64 offset = parser.value(offsetOption).toLongLong(&okOffset);
+    qint64 length = parser.value(lengthOption).toLongLong(&okLength);
+    if (!okOffset || offset < 0 || !okLength || length < -1) {
+        err << "filecompress: --offset and --length take byte counts\n";
+        return ExitUsage;
+    }
+    if (length < 0)
+        length = std::numeric_limits<qint64>::max();
+
+    QString outputDir = parser.value(outputOption);
+    if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+        err << "filecompress: cannot create output folder " << outputDir << "\n";
+        return ExitUsage;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (command == "c")
+        return runCompress(positional, outputDir, threads);
+    if (command == "d")
+        return runDecompress(positional, outputDir);
+    if (command == "t")
+        return runVerify(positional, threads);
+    if (command == "cat")
+        return runCat(positional, offset, length);
+    if (command == "bench")
+        return runBench(positional, threads, static_cast<size_t>(blockKb) * 1024, repeat);
+
+    err << "filecompress: unknown command '" << command << "' (expected c, d, t, cat or bench)\n";
+    return ExitUsage;
+}
@@ -1,7 +1,6 @@
 #include "compress.h"
 #include "theme.h"
-#include "huffman.h"
-#include "imagecom.h"
+#include "compressionjob.h"
 
 #include <QDebug>
 #include <QFont>
@@ -29,6 +28,7 @@
 #include <QDialogButtonBox>
 #include <QSizePolicy>
 #include "styledmessagebox.h"
+#include <QtConcurrent/QtConcurrentRun>
 
 CompressWindow::CompressWindow(QWidget *parent)
     : QWidget(parent)
@@ -70,10 +70,19 @@ CompressWindow::CompressWindow(QWidget *parent)
     // --- Signal/Slot Connections ---
     connect(addFileButton, &QPushButton::clicked, this, [=]() {
         QWidget *parentWindow = this->window();
-        QString filePath = QFileDialog::getOpenFileName(parentWindow,
-                                                        tr("Select File to Compress"),
-                                                        QDir::homePath(),
-                                                        tr("All Files (*.*)"));
+        QStringList filePaths = QFileDialog::getOpenFileNames(parentWindow,
+                                                              tr("Select File(s) to Compress"),
+                                                              QDir::homePath(),
+                                                              tr("All Files (*.*)"));
+        selectedBatchPaths.clear();
+        selectedBaseDir.clear();
+        if (filePaths.size() > 1) {
+            // Several files: they go through the batch queue
+            selectedFilePath.clear();
+            setBatchSelection(filePaths, QString("%1 files selected").arg(filePaths.size()));
+            return;
+        }
+        QString filePath = filePaths.value(0);
         if (!filePath.isEmpty()) {
             selectedFilePath = filePath;
             QFileInfo fileInfo(filePath);
@@ -101,7 +110,21 @@ CompressWindow::CompressWindow(QWidget *parent)
         }
     });
 
+    connect(addFolderButton, &QPushButton::clicked, this, [=]() {
+        QString dir = QFileDialog::getExistingDirectory(this->window(), tr("Select Folder to Compress"),
+                                                        QDir::homePath());
+        if (dir.isEmpty()) return;
+        selectedFilePath.clear();
+        selectedBaseDir = dir;
+        QStringList files = CompressionJob::collectFiles(dir);
+        setBatchSelection(files, QString("📂 %1 — %2 supported files").arg(QFileInfo(dir).fileName()).arg(files.size()));
+    });
+
     connect(startButton, &QPushButton::clicked, this, [=]() {
+        if (!selectedBatchPaths.isEmpty()) {
+            compressBatch(selectedBatchPaths);
+            return;
+        }
         if (selectedFilePath.isEmpty()) {
             QWidget *parentWindow = this->window();
             QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ No File Selected",
@@ -111,18 +134,34 @@ CompressWindow::CompressWindow(QWidget *parent)
             return;
         }
 
-        startButton->setEnabled(false);
-        QApplication::processEvents();
-
+        // Returns immediately; the buttons come back when the background job finishes
         compressSelectedFile(selectedFilePath);
+    });
 
-        startButton->setEnabled(true);
+    // --- Background job plumbing ---
+    jobWatcher = new QFutureWatcher<JobResult>(this);
+    connect(jobWatcher, &QFutureWatcher<JobResult>::finished, this, &CompressWindow::compressionJobFinished);
+    batchWatcher = new QFutureWatcher<BatchSummary>(this);
+    connect(batchWatcher, &QFutureWatcher<BatchSummary>::finished, this, &CompressWindow::batchJobFinished);
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(16); // ~60 fps, independent of how often the engine reports
+    connect(progressTimer, &QTimer::timeout, this, &CompressWindow::updateJobProgress);
+    connect(cancelButton, &QPushButton::clicked, this, [=]() {
+        jobProgress.cancel();
+        cancelButton->setEnabled(false);
+        progressLabel->setText("Cancelling...");
     });
 
     // Navigation connections are now in setupSidebar()
 }
 
-CompressWindow::~CompressWindow() = default;
+CompressWindow::~CompressWindow()
+{
+    // The job thread writes into jobProgress; stop it before the window goes away
+    jobProgress.cancel();
+    jobWatcher->waitForFinished();
+    batchWatcher->waitForFinished();
+}
 
 // =============================================================
 // ====================== UI SETUP METHODS =======================
@@ -244,7 +283,7 @@ void CompressWindow::setupContentArea()
     QHBoxLayout *fileButtonCenterLayout = new QHBoxLayout();
     fileButtonCenterLayout->addStretch(1);
     
-    addFileButton = new QPushButton("📁 Select File to Compress...");
+    addFileButton = new QPushButton("📁 Select File(s) to Compress...");
     addFileButton->setMinimumWidth(340);
     addFileButton->setMaximumWidth(620);
     addFileButton->setFixedHeight(78);
@@ -253,6 +292,14 @@ void CompressWindow::setupContentArea()
     addFileButton->setFont(buttonFont);
     
     fileButtonCenterLayout->addWidget(addFileButton);
+
+    // Whole folders (recursive) go straight to the batch queue
+    addFolderButton = new QPushButton("🗂️ Select Folder...");
+    addFolderButton->setMinimumWidth(200);
+    addFolderButton->setFixedHeight(78);
+    addFolderButton->setCursor(Qt::PointingHandCursor);
+    addFolderButton->setFont(buttonFont);
+    fileButtonCenterLayout->addWidget(addFolderButton);
     fileButtonCenterLayout->addStretch(1);
     contentLayout->addLayout(fileButtonCenterLayout);
     contentLayout->addSpacing(35);
@@ -402,7 +449,60 @@ void CompressWindow::setupContentArea()
     buttonLayout->addStretch();
     
     contentLayout->addLayout(buttonLayout);
-    contentLayout->addSpacing(30);
+    contentLayout->addSpacing(20);
+
+    // Progress row (visible only while a job runs): bar, bytes/throughput, cancel
+    progressContainer = new QWidget();
+    progressContainer->setObjectName("ProgressCard");
+    QVBoxLayout *progressLayout = new QVBoxLayout(progressContainer);
+    progressLayout->setContentsMargins(22, 12, 22, 12);
+    progressLayout->setSpacing(10);
+
+    QHBoxLayout *progressRow = new QHBoxLayout();
+    progressRow->setSpacing(15);
+    progressBar = new QProgressBar();
+    progressBar->setTextVisible(false);
+    progressBar->setFixedHeight(14);
+    progressBar->setStyleSheet(R"(
+        QProgressBar {
+            background: rgba(14, 165, 233, 0.15);
+            border: 1px solid rgba(14, 165, 233, 0.5);
+            border-radius: 7px;
+        }
+        QProgressBar::chunk {
+            background: qlineargradient(x1:0, y1:0, x2:1, y2:0, stop:0 #0ea5e9, stop:1 #38bdf8);
+            border-radius: 6px;
+        }
+    )");
+    progressRow->addWidget(progressBar, 1);
+
+    cancelButton = new QPushButton("✖ Cancel");
+    cancelButton->setFixedHeight(40);
+    cancelButton->setCursor(Qt::PointingHandCursor);
+    cancelButton->setFont(QFont("Segoe UI", 12, QFont::Bold));
+    cancelButton->setStyleSheet(R"(
+        QPushButton {
+            background: rgba(239, 68, 68, 0.2);
+            color: #fecaca;
+            border: 2px solid rgba(239, 68, 68, 0.6);
+            border-radius: 12px;
+            padding: 6px 18px;
+        }
+        QPushButton:hover { background: rgba(239, 68, 68, 0.35); }
+        QPushButton:disabled { color: rgba(254, 202, 202, 0.5); border-color: rgba(239, 68, 68, 0.25); }
+    )");
+    progressRow->addWidget(cancelButton);
+    progressLayout->addLayout(progressRow);
+
+    progressLabel = new QLabel();
+    progressLabel->setFont(QFont("Segoe UI", 12));
+    progressLabel->setStyleSheet("color: #bae6fd; background: transparent;");
+    progressLabel->setAlignment(Qt::AlignCenter);
+    progressLayout->addWidget(progressLabel);
+
+    progressContainer->setVisible(false);
+    contentLayout->addWidget(progressContainer);
+    contentLayout->addSpacing(10);
     contentLayout->addStretch(1);
 }
 
@@ -626,6 +726,8 @@ void CompressWindow::applyStyles()
         }
     )");
 
+    addFolderButton->setStyleSheet(addFileButton->styleSheet());
+
     startButton->setStyleSheet(R"(
         QPushButton {
             background: qlineargradient(x1:0, y1:0, x2:0, y2:1,
@@ -724,223 +826,263 @@ void CompressWindow::setupAnimations()
 void CompressWindow::compressSelectedFile(const QString &path) {
     QFileInfo fileInfo(path);
     QString extension = fileInfo.suffix().toLower();
-
-    QLocale locale;
     qint64 originalSize = fileInfo.size();
 
     // --- FILE TYPE CATEGORIZATION ---
-    bool isVideo = (extension == "mp4" || extension == "avi" || extension == "mov" || extension == "mkv");
-    bool isImage = (extension == "png" || extension == "bmp" || extension == "tiff" || extension == "tif" || extension == "jpg" || extension == "jpeg");
-    bool isTextData = (extension == "txt" || extension == "pdf");
-
-    // --- 1. HANDLE IMAGE AND VIDEO FILES (OpenCV Lossy Compression) ---
-    if (isImage || isVideo) {
+    QString fileType = CompressionJob::fileTypeFor(extension);
 
-        QString fileType = isVideo ? "Video" : "Image";
-        QString outputExtension = isVideo ? "avi" : "jpg";
-        // Use selected save location if set, otherwise use file's directory
-        QString outputDir = saveLocationPath.isEmpty() ? fileInfo.absolutePath() : saveLocationPath;
-        QString outPath = QDir(outputDir).filePath(fileInfo.baseName() + "_compressed." + outputExtension);
-
-        bool success = false;
-        int quality = isVideo ? 70 : 85;
-
-        if (isVideo) {
-            success = ImageCompressor::compressAndSaveVideo(path.toStdString(), outPath.toStdString(), quality);
-        } else {
-            success = ImageCompressor::compressAndSaveSingleImage(path.toStdString(), outPath.toStdString(), quality);
-        }
-
-        QFile outFile(outPath);
-        qint64 compressedSize = outFile.exists() ? outFile.size() : originalSize;
-
-        if (success) {
-            if (compressedSize >= originalSize && compressedSize != 0) {
-                QWidget *parentWindow = this->window();
-                QMessageBox *msgBox = createStyledMessageBox(parentWindow, "ℹ️ " + fileType + " Compression Skipped",
-                                         QString("⚠️ %1 compression was skipped.\n\nReason: Output size was not smaller than the original.\n\n📊 Original Size: <b style='color: #0ea5e9;'>%2 Bytes</b>")
-                                             .arg(fileType)
-                                             .arg(locale.toString(originalSize)), QMessageBox::Warning);
-                msgBox->exec();
-                delete msgBox;
-                updateCompressionChart(originalSize, originalSize);
-                QFile::remove(outPath);
-                return;
-            }
-
-            double ratio = 100.0 * (1.0 - (double)compressedSize / originalSize);
-
-            QWidget *parentWindow = this->window();
-            QString originalSizeStr = formatFileSize(originalSize);
-            QString compressedSizeStr = formatFileSize(compressedSize);
-            QString reductionStr = QString::number(ratio, 'f', 2) + "%";
-            QMessageBox *msgBox = createStyledMessageBox(parentWindow, "✅ Success (" + fileType + ")",
-                                     QString("<div style='font-size: 20px; font-weight: bold; color: #0ea5e9; margin-bottom: 20px; text-align: center;'>🎉 %1 Compression finished!</div>"
-                                             "<div style='margin: 15px 0; padding: 15px; background: rgba(14, 165, 233, 0.1); border-radius: 12px;'>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📁 Saved to:</b><br><span style='color: #ffffff; font-size: 14px;'>%2</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Original Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%3</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Compressed Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%4</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📈 Reduction:</b> <span style='color: #0ea5e9; font-size: 18px; font-weight: bold;'>%5</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>⚙️ Quality:</b> <span style='color: #ffffff;'>%6</span></div>"
-                                             "</div>")
-                                         .arg(fileType)
-                                         .arg(outPath)
-                                         .arg(originalSizeStr)
-                                         .arg(compressedSizeStr)
-                                         .arg(reductionStr)
-                                         .arg(quality));
-            msgBox->exec();
-            delete msgBox;
-
-            updateCompressionChart(originalSize, compressedSize);
-            
-            // Store file path for history
-            setProperty("lastCompressedFile", path);
-            
-            // Emit signal to update dashboard and visualizer
-            emit compressionCompleted(originalSize, compressedSize);
-            emit compressionCompletedWithType(fileType, originalSize, compressedSize);
-        } else {
-            QWidget *parentWindow = this->window();
-            QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                     QString("❌ %1 Compression failed!\n\nPlease check console for OpenCV errors.").arg(fileType), QMessageBox::Critical);
-            msgBox->exec();
-            delete msgBox;
-            updateCompressionChart(originalSize, originalSize);
-        }
+    // --- FALLBACK / UNSUPPORTED FILE TYPE ---
+    if (fileType.isEmpty()) {
+        QWidget *parentWindow = this->window();
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Unsupported File Type",
+                             QString("⚠️ File type '.%1' is not supported.\n\n✅ Supported formats:\n• .txt files\n• .pdf files\n• Images (jpg, png, etc.)\n• Videos (mp4, avi, etc.)")
+                                 .arg(extension), QMessageBox::Warning);
+        msgBox->exec();
+        delete msgBox;
+        updateCompressionChart(originalSize, originalSize);
         return;
     }
 
-    // --- 2. HANDLE TEXT/PDF FILES (Huffman/Fake Compression) ---
-    if (isTextData) {
-
-        QFile file(path);
-        if (!file.open(QFile::ReadOnly)) {
-            QWidget *parentWindow = this->window();
-            QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                     "❌ Cannot open input file for reading.\n\nPlease check file permissions.", QMessageBox::Critical);
-            msgBox->exec();
-            delete msgBox;
-            return;
-        }
+    // Text/PDF files are streamed through the encoder, so only their size is needed up front
+    if ((fileType == "PDF" || fileType == "Text") && originalSize == 0) {
+        QWidget *parentWindow = this->window();
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Empty File",
+                                 "⚠️ The selected file is empty.\n\nNothing to compress.", QMessageBox::Warning);
+        msgBox->exec();
+        delete msgBox;
+        // Reset size labels
+        originalSizeLabel->setText("--");
+        compressedSizeLabel->setText("--");
+        return;
+    }
 
-        QByteArray data = file.readAll();
-        file.close();
+    // --- RUN THE ENGINE OFF THE GUI THREAD ---
+    // Huffman (PDF/TXT) and OpenCV (images/videos) both run on a pool thread;
+    // compressionJobFinished() reports the result back on the GUI thread.
+    jobPath = path;
+    jobProgress.resetBatch(originalSize, 1);
+    QString outputDir = saveLocationPath;
+    setJobRunning(true);
+    jobWatcher->setFuture(QtConcurrent::run([this, path, outputDir]() {
+        return CompressionJob::compressFile(path, outputDir, jobProgress);
+    }));
+}
 
-        std::vector<uint8_t> inputBytes(data.begin(), data.end());
+void CompressWindow::setJobRunning(bool running) {
+    startButton->setEnabled(!running);
+    addFileButton->setEnabled(!running);
+    addFolderButton->setEnabled(!running);
+    progressContainer->setVisible(running);
+    cancelButton->setEnabled(running);
+    if (running) {
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(0);
+        progressLabel->setText("Starting...");
+        jobClock.start();
+        progressTimer->start();
+    } else {
+        progressTimer->stop();
+    }
+}
 
-        if (inputBytes.empty()) {
-            QWidget *parentWindow = this->window();
-            QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Empty File",
-                                     "⚠️ The selected file is empty.\n\nNothing to compress.", QMessageBox::Warning);
-            msgBox->exec();
-            delete msgBox;
-            // Reset size labels
-            originalSizeLabel->setText("--");
-            compressedSizeLabel->setText("--");
-            return;
-        }
+// Polled by progressTimer (~60 Hz): reads the job's atomics, never blocks
+void CompressWindow::updateJobProgress() {
+    qint64 done = jobProgress.processed();
+    qint64 total = jobProgress.total();
+    double seconds = jobClock.elapsed() / 1000.0;
+
+    if (total > 0) {
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(static_cast<int>(1000.0 * qMin(done, total) / total));
+    } else {
+        progressBar->setRange(0, 0); // busy indicator until the size is known
+    }
+    QString rate = (seconds > 0.05 && done > 0) ? formatFileSize(static_cast<qint64>(done / seconds)) + "/s" : "--";
+    QString files = jobProgress.filesTotal() > 1
+                        ? QString("%1 / %2 files  •  ").arg(jobProgress.filesDone()).arg(jobProgress.filesTotal())
+                        : QString();
+    progressLabel->setText(QString("%1%2 / %3  •  %4")
+                               .arg(files)
+                               .arg(formatFileSize(done))
+                               .arg(total > 0 ? formatFileSize(total) : QString("?"))
+                               .arg(rate));
+}
 
-        qint64 compressedSize = 0;
-        QString outPath;
-        bool successfulCompression = false;
-        // Use selected save location if set, otherwise use file's directory
-        QString outputDir = saveLocationPath.isEmpty() ? fileInfo.absolutePath() : saveLocationPath;
-        outPath = QDir(outputDir).filePath(fileInfo.fileName() + ".huff"); // Consistent output extension
+// Shows a multi-file selection; Start then runs it through the batch queue
+void CompressWindow::setBatchSelection(const QStringList &paths, const QString &label) {
+    selectedBatchPaths = paths;
+    qint64 totalSize = 0;
+    for (const QString &path : paths) totalSize += QFileInfo(path).size();
+    filePathLabel->setText(paths.isEmpty() ? QString("No supported files found") : label);
+    originalSizeLabel->setText(paths.isEmpty() ? QString("--") : formatFileSize(totalSize));
+    compressedSizeLabel->setText("--");
+}
 
+// =============================================================
+// ===================== BATCH COMPRESSION ======================
+// =============================================================
+void CompressWindow::compressBatch(const QStringList &paths) {
+    qint64 totalSize = 0;
+    for (const QString &path : paths) totalSize += QFileInfo(path).size();
+
+    // Files are taken off one queue by a bounded pool (one worker per core);
+    // batchJobFinished() gets a single summary when the queue is drained
+    jobProgress.resetBatch(totalSize, paths.size());
+    QString outputDir = saveLocationPath;
+    QString baseDir = selectedBaseDir;
+    setJobRunning(true);
+    batchWatcher->setFuture(QtConcurrent::run([this, paths, outputDir, baseDir]() {
+        return CompressionJob::compressBatch(paths, outputDir, baseDir, 0, jobProgress);
+    }));
+}
 
-        // --- HUFFMAN LOGIC FOR PDF AND TXT ---
-        if (extension == "pdf" || extension == "txt") {
-            std::vector<uint8_t> compressed;
+void CompressWindow::batchJobFinished() {
+    setJobRunning(false);
+    BatchSummary summary = batchWatcher->result();
+    QWidget *parentWindow = this->window();
 
-            bool ok = Huffman::compressBytes(inputBytes, compressed);
+    double ratio = summary.originalBytes > 0
+                       ? 100.0 * (1.0 - (double)summary.compressedBytes / summary.originalBytes) : 0.0;
+    double seconds = summary.elapsedMs / 1000.0;
+    qint64 rate = seconds > 0 ? static_cast<qint64>(jobProgress.processed() / seconds) : 0;
+
+    // One report for the whole batch; failures are listed (up to 10). They are appended
+    // after the arg() chain so file names containing "%1" cannot be substituted.
+    QString failures;
+    for (int i = 0; i < summary.failures.size() && i < 10; ++i)
+        failures += "<br><span style='color: #fecaca; font-size: 13px;'>• " + summary.failures[i].toHtmlEscaped() + "</span>";
+    if (summary.failures.size() > 10)
+        failures += QString("<br><span style='color: #fecaca; font-size: 13px;'>… and %1 more</span>").arg(summary.failures.size() - 10);
+    if (!failures.isEmpty())
+        failures = "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>❌ Failed files:</b>" + failures + "</div>";
+
+    QMessageBox *msgBox = createStyledMessageBox(parentWindow, summary.cancelled ? "ℹ️ Batch Cancelled" : "✅ Batch Finished",
+                             QString("<div style='font-size: 20px; font-weight: bold; color: #0ea5e9; margin-bottom: 20px; text-align: center;'>%1</div>"
+                                     "<div style='margin: 15px 0; padding: 15px; background: rgba(14, 165, 233, 0.1); border-radius: 12px;'>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>✅ Compressed:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%2</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>⏭️ Skipped (not smaller / empty):</b> <span style='color: #ffffff;'>%3</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>❌ Failed:</b> <span style='color: #ffffff;'>%4</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>⛔ Not run (cancelled):</b> <span style='color: #ffffff;'>%5</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%6 → %7</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📈 Reduction:</b> <span style='color: #0ea5e9; font-size: 18px; font-weight: bold;'>%8</span></div>"
+                                     "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>⏱️ Time:</b> <span style='color: #ffffff;'>%9 s (%10/s)</span></div>")
+                                 .arg(summary.cancelled ? "Batch compression cancelled" : "🎉 Batch compression finished!")
+                                 .arg(summary.succeeded)
+                                 .arg(summary.skipped)
+                                 .arg(summary.failed)
+                                 .arg(summary.cancelled)
+                                 .arg(formatFileSize(summary.originalBytes))
+                                 .arg(formatFileSize(summary.compressedBytes))
+                                 .arg(QString::number(ratio, 'f', 2) + "%")
+                                 .arg(QString::number(seconds, 'f', 1))
+                                 .arg(formatFileSize(rate))
+                                 + failures + "</div>",
+                             summary.failed ? QMessageBox::Warning : QMessageBox::Information);
+    msgBox->exec();
+    delete msgBox;
 
-            if (!ok) {
-                QWidget *parentWindow = this->window();
-                QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                         "❌ Huffman Compression failed!\n\nPlease try again.", QMessageBox::Critical);
-                msgBox->exec();
-                delete msgBox;
-                return;
-            }
+    if (summary.records.isEmpty()) return;
+    updateCompressionChart(summary.originalBytes, summary.compressedBytes);
 
-            compressedSize = (qint64)compressed.size();
-            successfulCompression = true;
-
-            // CRITICAL CHECK: Only save if size is STRICTLY reduced (Huffman is lossless)
-            if (compressedSize >= originalSize) {
-                QWidget *parentWindow = this->window();
-                QMessageBox *msgBox = createStyledMessageBox(parentWindow, "ℹ️ Compression Skipped",
-                                         QString("⚠️ Huffman compression was skipped.\n\nReason: Size did not decrease for .%1 files.\n\n📊 Original Size: <b style='color: #0ea5e9;'>%2 Bytes</b>")
-                                             .arg(extension.toUpper())
-                                             .arg(locale.toString(originalSize)), QMessageBox::Warning);
-                msgBox->exec();
-                delete msgBox;
-                updateCompressionChart(originalSize, originalSize);
-                return;
-            }
-
-            // Write actual Huffman output file
-            QFile outFile(outPath);
-            if (!outFile.open(QFile::WriteOnly)) {
-                QWidget *parentWindow = this->window();
-                QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                         "❌ Cannot open output file for writing.\n\nPlease check file permissions.", QMessageBox::Critical);
-                msgBox->exec();
-                delete msgBox;
-                return;
-            }
-            outFile.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
-            outFile.close();
-        }
+    // Everything is recorded in one go: History/Dashboard/Visualizer save and redraw once
+    emit batchCompressionCompleted(summary.records);
+}
 
+void CompressWindow::compressionJobFinished() {
+    setJobRunning(false);
+    JobResult result = jobWatcher->result();
+    QString path = jobPath;
+    QFileInfo fileInfo(path);
+    QString extension = fileInfo.suffix().toLower();
+    QLocale locale;
+    qint64 originalSize = result.inputSize;
+    qint64 compressedSize = result.outputSize;
+    bool isTextData = (result.fileType == "PDF" || result.fileType == "Text");
+    QWidget *parentWindow = this->window();
 
-        // --- REPORT SUCCESS ---
-        if (successfulCompression) {
-            double ratio = 100.0 * (1.0 - (double)compressedSize / originalSize);
+    if (result.status == JobResult::Cancelled) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "ℹ️ Compression Cancelled",
+                                 "ℹ️ Compression was cancelled.\n\nNo output file was kept.", QMessageBox::Information);
+        msgBox->exec();
+        delete msgBox;
+        updateCompressionChart(originalSize, originalSize);
+        return;
+    }
 
-            QWidget *parentWindow = this->window();
-            QString originalSizeStr = formatFileSize(originalSize);
-            QString compressedSizeStr = formatFileSize(compressedSize);
-            QString reductionStr = QString::number(ratio, 'f', 2) + "%";
-            QMessageBox *msgBox = createStyledMessageBox(parentWindow, "✅ Success (Data File)",
-                                     QString("<div style='font-size: 20px; font-weight: bold; color: #0ea5e9; margin-bottom: 20px; text-align: center;'>🎉 Huffman Compression finished!</div>"
-                                             "<div style='margin: 15px 0; padding: 15px; background: rgba(14, 165, 233, 0.1); border-radius: 12px;'>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📁 Saved to:</b><br><span style='color: #ffffff; font-size: 14px;'>%1</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Original Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%2</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Compressed Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%3</span></div>"
-                                             "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📈 Reduction:</b> <span style='color: #0ea5e9; font-size: 18px; font-weight: bold;'>%4</span></div>"
-                                             "</div>")
-                                         .arg(outPath)
-                                         .arg(originalSizeStr)
-                                         .arg(compressedSizeStr)
-                                         .arg(reductionStr));
-            msgBox->exec();
-            delete msgBox;
+    if (result.status == JobResult::Failed) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error", result.error, QMessageBox::Critical);
+        msgBox->exec();
+        delete msgBox;
+        if (!isTextData) updateCompressionChart(originalSize, originalSize);
+        return;
+    }
 
-            updateCompressionChart(originalSize, compressedSize);
-            
-            // Determine file type for text/PDF
-            QString fileType = (extension == "pdf") ? "PDF" : "Text";
-            
-            // Store file path for history
-            setProperty("lastCompressedFile", path);
-            
-            // Emit signal to update dashboard and visualizer
-            emit compressionCompleted(originalSize, compressedSize);
-            emit compressionCompletedWithType(fileType, originalSize, compressedSize);
+    if (result.status == JobResult::NotSmaller) {
+        QMessageBox *msgBox;
+        if (isTextData) {
+            msgBox = createStyledMessageBox(parentWindow, "ℹ️ Compression Skipped",
+                                 QString("⚠️ Huffman compression was skipped.\n\nReason: Size did not decrease for .%1 files.\n\n📊 Original Size: <b style='color: #0ea5e9;'>%2 Bytes</b>")
+                                     .arg(extension.toUpper())
+                                     .arg(locale.toString(originalSize)), QMessageBox::Warning);
+        } else {
+            msgBox = createStyledMessageBox(parentWindow, "ℹ️ " + result.fileType + " Compression Skipped",
+                                 QString("⚠️ %1 compression was skipped.\n\nReason: Output size was not smaller than the original.\n\n📊 Original Size: <b style='color: #0ea5e9;'>%2 Bytes</b>")
+                                     .arg(result.fileType)
+                                     .arg(locale.toString(originalSize)), QMessageBox::Warning);
         }
+        msgBox->exec();
+        delete msgBox;
+        updateCompressionChart(originalSize, originalSize);
         return;
     }
 
-    // --- 3. FALLBACK / UNSUPPORTED FILE TYPE ---
-    QWidget *parentWindow = this->window();
-    QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Unsupported File Type",
-                         QString("⚠️ File type '.%1' is not supported.\n\n✅ Supported formats:\n• .txt files\n• .pdf files\n• Images (jpg, png, etc.)\n• Videos (mp4, avi, etc.)")
-                             .arg(extension), QMessageBox::Warning);
+    // --- REPORT SUCCESS ---
+    double ratio = 100.0 * (1.0 - (double)compressedSize / originalSize);
+    QString originalSizeStr = formatFileSize(originalSize);
+    QString compressedSizeStr = formatFileSize(compressedSize);
+    QString reductionStr = QString::number(ratio, 'f', 2) + "%";
+    QMessageBox *msgBox;
+    if (isTextData) {
+        msgBox = createStyledMessageBox(parentWindow, "✅ Success (Data File)",
+                                 QString("<div style='font-size: 20px; font-weight: bold; color: #0ea5e9; margin-bottom: 20px; text-align: center;'>🎉 Huffman Compression finished!</div>"
+                                         "<div style='margin: 15px 0; padding: 15px; background: rgba(14, 165, 233, 0.1); border-radius: 12px;'>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📁 Saved to:</b><br><span style='color: #ffffff; font-size: 14px;'>%1</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Original Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%2</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Compressed Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%3</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📈 Reduction:</b> <span style='color: #0ea5e9; font-size: 18px; font-weight: bold;'>%4</span></div>"
+                                         "</div>")
+                                     .arg(result.outPath)
+                                     .arg(originalSizeStr)
+                                     .arg(compressedSizeStr)
+                                     .arg(reductionStr));
+    } else {
+        msgBox = createStyledMessageBox(parentWindow, "✅ Success (" + result.fileType + ")",
+                                 QString("<div style='font-size: 20px; font-weight: bold; color: #0ea5e9; margin-bottom: 20px; text-align: center;'>🎉 %1 Compression finished!</div>"
+                                         "<div style='margin: 15px 0; padding: 15px; background: rgba(14, 165, 233, 0.1); border-radius: 12px;'>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📁 Saved to:</b><br><span style='color: #ffffff; font-size: 14px;'>%2</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Original Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%3</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📊 Compressed Size:</b> <span style='color: #0ea5e9; font-weight: bold; font-size: 16px;'>%4</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>📈 Reduction:</b> <span style='color: #0ea5e9; font-size: 18px; font-weight: bold;'>%5</span></div>"
+                                         "<div style='margin: 10px 0;'><b style='color: #bae6fd;'>⚙️ Quality:</b> <span style='color: #ffffff;'>%6</span></div>"
+                                         "</div>")
+                                     .arg(result.fileType)
+                                     .arg(result.outPath)
+                                     .arg(originalSizeStr)
+                                     .arg(compressedSizeStr)
+                                     .arg(reductionStr)
+                                     .arg(result.quality));
+    }
     msgBox->exec();
     delete msgBox;
-    updateCompressionChart(originalSize, originalSize);
+
+    updateCompressionChart(originalSize, compressedSize);
+
+    // Store file path for history
+    setProperty("lastCompressedFile", path);
+
+    // Emit signal to update dashboard and visualizer
+    emit compressionCompleted(originalSize, compressedSize);
+    emit compressionCompletedWithType(result.fileType, originalSize, compressedSize);
 }
 
 
@@ -9,7 +9,12 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QResizeEvent>
+#include <QProgressBar>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <vector>
+#include "compressionjob.h"
 
 // QtCharts headers
 #include <QtCharts/QChartView>
@@ -34,10 +39,18 @@ signals:
     void navigateToAboutHelp();
     void compressionCompleted(qint64 originalSize, qint64 compressedSize);
     void compressionCompletedWithType(const QString &fileType, qint64 originalSize, qint64 compressedSize);
+    // A whole batch at once, so receivers save and refresh a single time
+    void batchCompressionCompleted(const QVector<BatchRecord> &records);
 
 private slots:
     // Slot for the main compression logic (the dispatcher)
     void compressSelectedFile(const QString &path);
+    // Background job: progress polling and completion on the GUI thread
+    void updateJobProgress();
+    void compressionJobFinished();
+    // Batch queue (several files or a folder)
+    void compressBatch(const QStringList &paths);
+    void batchJobFinished();
 
 public:
     void applyTheme();
@@ -52,6 +65,8 @@ private:
     void setupAnimations();
     void updateCompressionChart(qint64 originalSize, qint64 compressedSize);
     void updateResponsiveSizes();
+    void setJobRunning(bool running);
+    void setBatchSelection(const QStringList &paths, const QString &label);
 
     // Core UI Components
     QWidget *mainCentralWidget;
@@ -71,9 +86,12 @@ private:
     QVBoxLayout *contentLayout;
     QLabel *titleLabel;
     QPushButton *addFileButton;
+    QPushButton *addFolderButton;
     QLabel *filePathLabel;
     QPushButton *startButton;
     QString selectedFilePath;
+    QStringList selectedBatchPaths;   // set instead of selectedFilePath for multi-file/folder runs
+    QString selectedBaseDir;          // folder selection root (sub-folders are mirrored on save)
     QPushButton *selectSaveLocationButton;
     QLabel *saveLocationLabel;
     QString saveLocationPath;
@@ -83,6 +101,18 @@ private:
     QChartView *chartView;
     QLabel *originalSizeLabel;
     QLabel *compressedSizeLabel;
+
+    // --- BACKGROUND JOB (progress + cancel) ---
+    QWidget *progressContainer;
+    QProgressBar *progressBar;
+    QLabel *progressLabel;
+    QPushButton *cancelButton;
+    QTimer *progressTimer;
+    QElapsedTimer jobClock;
+    QFutureWatcher<JobResult> *jobWatcher;
+    QFutureWatcher<BatchSummary> *batchWatcher;
+    BatchProgress jobProgress;
+    QString jobPath;
 };
 
 #endif // COMPRESS_H
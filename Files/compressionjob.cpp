@@ -0,0 +1,646 @@
+#include "compressionjob.h"
+#include "devicestream.h"
+#include "fse.h"
+#include "histogram.h"
+#include "imagecom.h"
+#include "lz77.h"
+
+#include "parallel.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSettings>
+#include <QByteArray>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// =============================================================
+// ======================== JOB PROGRESS ========================
+// =============================================================
+void JobProgress::reset(qint64 totalBytes)
+{
+    done = 0;
+    expected = totalBytes;
+    cancelRequested = false;
+}
+
+bool JobProgress::report(qint64 processedBytes, qint64 totalBytes)
+{
+    qint64 previous = done.exchange(processedBytes);
+    if (parent) parent->done += processedBytes - previous;
+    // Keep the caller's estimate (e.g. the file size) while the engine does not know yet
+    if (totalBytes > 0) expected = totalBytes;
+    return !isCancelled();
+}
+
+bool JobProgress::update(uint64_t processedBytes, uint64_t totalBytes)
+{
+    return report((qint64)processedBytes, (qint64)totalBytes);
+}
+
+QString JobResult::errorSummary() const
+{
+    return error.section('\n', 0, 0).remove(QStringLiteral("❌ ")).trimmed();
+}
+
+void BatchProgress::resetBatch(qint64 totalBytes, int totalFiles)
+{
+    reset(totalBytes);
+    finished = 0;
+    fileCount = totalFiles;
+}
+
+namespace CompressionJob {
+
+QString fileTypeFor(const QString &extension)
+{
+    QString ext = extension.toLower();
+    if (ext == "mp4" || ext == "avi" || ext == "mov" || ext == "mkv") return "Video";
+    if (ext == "png" || ext == "bmp" || ext == "tiff" || ext == "tif" || ext == "jpg" || ext == "jpeg") return "Image";
+    if (ext == "pdf") return "PDF";
+    if (ext == "txt") return "Text";
+    return QString();
+}
+
+// =============================================================
+// ======================== COMPRESSION =========================
+// =============================================================
+
+// Output file name for an input of the given type. Media outputs keep the source suffix:
+// "a.png" and "a.jpg" (or "a.v1.png" and "a.v2.png") of one batch must not share one.
+static QString outputNameFor(const QFileInfo &fileInfo, const QString &fileType)
+{
+    if (fileType == "Video" || fileType == "Image")
+        return fileInfo.completeBaseName() + "_" + fileInfo.suffix().toLower() + "_compressed." +
+               (fileType == "Video" ? "avi" : "jpg");
+    return fileInfo.fileName() + ".huff";
+}
+
+// OpenCV lossy path (images, videos)
+static JobResult compressMedia(const QFileInfo &fileInfo, const QString &outputDir, JobProgress &progress,
+                               int threads, JobResult result)
+{
+    bool isVideo = result.fileType == "Video";
+    // OpenCV picks the format from the extension, so the temporary name keeps it
+    QFileInfo outName(outputNameFor(fileInfo, result.fileType));
+    QString outPath = QDir(outputDir).filePath(outName.fileName());
+    QString partPath = QDir(outputDir).filePath(outName.completeBaseName() + ".part." + outName.suffix());
+    // Quality and codec as saved in the Settings window (its defaults when never saved)
+    QSettings settings;
+    result.quality = isVideo ? settings.value("settings/videoQuality", 70).toInt()
+                             : settings.value("settings/imageQuality", 85).toInt();
+
+    bool success;
+    if (isVideo) {
+        // Frames are the unit of work; report them as a share of the input size
+        qint64 inputSize = result.inputSize;
+        ImageCompressor::VideoOptions options;
+        options.threads = threads;
+        ImageCompressor::videoCodecFromName(settings.value("settings/videoCodec", "XVID").toString().toStdString(),
+                                            options.codec);
+        options.duplicateThreshold = settings.value("settings/videoDuplicateThreshold", -1).toInt();
+        success = ImageCompressor::compressAndSaveVideo(
+            fileInfo.absoluteFilePath().toStdString(), partPath.toStdString(), result.quality,
+            [&progress, inputSize](long long done, long long total) {
+                qint64 bytes = total > 0 ? (qint64)((double)inputSize * qMin(done, total) / total) : 0;
+                return progress.report(bytes, inputSize);
+            },
+            options);
+    } else {
+        success = ImageCompressor::compressAndSaveSingleImage(fileInfo.absoluteFilePath().toStdString(),
+                                                              partPath.toStdString(), result.quality);
+    }
+
+    if (!success) {
+        QFile::remove(partPath);
+        result.status = progress.isCancelled() ? JobResult::Cancelled : JobResult::Failed;
+        result.error = QString("❌ %1 Compression failed!\n\nPlease check console for OpenCV errors.").arg(result.fileType);
+        return result;
+    }
+
+    QFile outFile(partPath);
+    result.outputSize = outFile.exists() ? outFile.size() : result.inputSize;
+    progress.report(result.inputSize, result.inputSize);
+    if (result.outputSize >= result.inputSize && result.outputSize != 0) {
+        QFile::remove(partPath);
+        result.status = JobResult::NotSmaller;
+        return result;
+    }
+    QFile::remove(outPath);
+    if (!QFile::rename(partPath, outPath)) {
+        QFile::remove(partPath);
+        result.error = "❌ Cannot open output file for writing.\n\nPlease check file permissions.";
+        return result;
+    }
+    result.outPath = outPath;
+    result.status = JobResult::Succeeded;
+    return result;
+}
+
+// Lossless coders, told apart by their magic when decompressing
+enum class Codec { Huffman, Fse, Lz77 };
+
+// Up to 16 slices of 64 KB spread over the data
+static std::vector<uint8_t> sampleOf(const uint8_t *data, size_t size)
+{
+    const size_t slice = 64 * 1024;
+    const size_t slices = qMin<size_t>(16, (size + slice - 1) / slice);
+    std::vector<uint8_t> sample;
+    for (size_t i = 0; i < slices; ++i) {
+        size_t offset = slices > 1 ? (size - slice) / (slices - 1) * i : 0;
+        sample.insert(sample.end(), data + offset, data + offset + qMin(slice, size - offset));
+    }
+    return sample;
+}
+
+// LZ77 + Huffman by default: text and PDF objects are full of repeated strings.
+// When one byte value covers half of the sample, an order-0 tANS coder can beat it
+// (skewed data without repeats), so both code the sample and the smaller one wins.
+// Returns false when nothing would shrink the data: the histogram estimate says
+// Huffman cannot (near 8 bits per byte) and LZ77 finds no repeats in the sample.
+static bool chooseCodec(const uint8_t *data, size_t size, Codec &codec)
+{
+    codec = Codec::Lz77;
+    std::vector<uint8_t> sample = sampleOf(data, size);
+    if (sample.empty())
+        return true;
+    Histogram::Counts counts = Histogram::count(sample.data(), sample.size());
+
+    Lz77::Options options;
+    options.level = 1;
+    options.threads = 1;
+    std::vector<uint8_t> lz, fse;
+    Huffman::Estimate estimate;
+    if (Huffman::estimate(counts, estimate) && estimate.compressedSize >= sample.size())
+        return !Lz77::compressBytes(sample, lz, options) || lz.size() < sample.size();
+
+    if (*std::max_element(counts.begin(), counts.end()) * 2 < sample.size())
+        return true;
+    if (!Lz77::compressBytes(sample, lz, options) || !Fse::compressBytes(sample, fse, options))
+        return true;
+    if (fse.size() < lz.size())
+        codec = Codec::Fse;
+    return true;
+}
+
+// Lossless path (PDF, text): LZ77 + Huffman, or FSE for skewed data without repeats
+static JobResult compressData(const QFileInfo &fileInfo, const QString &outputDir, JobProgress &progress,
+                              int threads, JobResult result)
+{
+    QFile file(fileInfo.absoluteFilePath());
+    if (!file.open(QFile::ReadOnly)) {
+        result.error = "❌ Cannot open input file for reading.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    // Compress straight from the page cache when the file can be mapped; otherwise
+    // stream file to file so memory stays bounded by the block size (the coder is
+    // then picked from the first megabyte)
+    const uchar *mapped = file.map(0, file.size());
+    Codec codec = Codec::Lz77;
+    if (mapped && !chooseCodec(mapped, (size_t)file.size(), codec)) {
+        // Samples from the whole file cannot shrink (e.g. a PDF of already compressed
+        // streams): skip the encode rather than write an output that is thrown away
+        file.unmap(const_cast<uchar *>(mapped));
+        progress.report(result.inputSize, result.inputSize);
+        result.status = JobResult::NotSmaller;
+        return result;
+    }
+
+    QString outPath = QDir(outputDir).filePath(outputNameFor(fileInfo, result.fileType)); // Consistent output extension
+    // Encode under a temporary name: an archive from an earlier run survives a failure,
+    // a cancel or an output that does not shrink
+    QString partPath = outPath + ".part";
+    QFile outFile(partPath);
+    if (!outFile.open(QFile::WriteOnly)) {
+        if (mapped) file.unmap(const_cast<uchar *>(mapped));
+        result.error = "❌ Cannot open output file for writing.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    // Both coders split the input into blocks, so every core takes a share
+    Lz77::Options options;
+    options.progress = &progress;
+    options.threads = threads;
+
+    bool ok;
+    if (mapped) {
+        std::vector<uint8_t> compressed;
+        if (codec == Codec::Fse)
+            ok = Fse::compressBytes(mapped, (size_t)file.size(), compressed, options);
+        else
+            ok = Lz77::compressBytes(mapped, (size_t)file.size(), compressed, options);
+        file.unmap(const_cast<uchar *>(mapped));
+        ok = ok && outFile.write(reinterpret_cast<const char*>(compressed.data()), (qint64)compressed.size())
+                   == (qint64)compressed.size();
+    } else {
+        QByteArray sample = file.peek(1 << 20);
+        DeviceInput input(file);
+        DeviceOutput output(outFile);
+        // The first megabyte says too little about the rest to skip the file
+        chooseCodec(reinterpret_cast<const uint8_t *>(sample.constData()), (size_t)sample.size(), codec);
+        if (codec == Codec::Fse)
+            ok = Fse::compressStream(input, output, options);
+        else
+            ok = Lz77::compressStream(input, output, options);
+    }
+    result.outputSize = outFile.size();
+    outFile.close();
+    file.close();
+
+    if (!ok) {
+        QFile::remove(partPath);
+        result.status = progress.isCancelled() ? JobResult::Cancelled : JobResult::Failed;
+        result.error = "❌ Compression failed!\n\nPlease try again.";
+        return result;
+    }
+
+    // CRITICAL CHECK: Only keep the output if size is STRICTLY reduced (the path is lossless)
+    if (result.outputSize >= result.inputSize) {
+        QFile::remove(partPath);
+        result.status = JobResult::NotSmaller;
+        return result;
+    }
+    QFile::remove(outPath);
+    if (!QFile::rename(partPath, outPath)) {
+        QFile::remove(partPath);
+        result.error = "❌ Cannot open output file for writing.\n\nPlease check file permissions.";
+        return result;
+    }
+    result.outPath = outPath;
+    result.status = JobResult::Succeeded;
+    return result;
+}
+
+JobResult compressFile(const QString &path, const QString &outputDir, JobProgress &progress, int threads)
+{
+    QFileInfo fileInfo(path);
+    JobResult result;
+    result.inputPath = path;
+    result.fileType = fileTypeFor(fileInfo.suffix());
+    result.inputSize = fileInfo.size();
+    result.outputSize = result.inputSize;
+    progress.report(0, result.inputSize); // no reset: a cancel may already be pending
+
+    // Use the given save location if set, otherwise the file's directory
+    QString dir = outputDir.isEmpty() ? fileInfo.absolutePath() : outputDir;
+
+    if (result.fileType == "Video" || result.fileType == "Image")
+        return compressMedia(fileInfo, dir, progress, threads, result);
+    if (result.fileType == "PDF" || result.fileType == "Text")
+        return compressData(fileInfo, dir, progress, threads, result);
+
+    result.error = QString("❌ Unsupported file type: .%1").arg(fileInfo.suffix());
+    return result;
+}
+
+// =============================================================
+// ======================= DECOMPRESSION ========================
+// =============================================================
+static Codec codecOf(const QByteArray &magic)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(magic.constData());
+    if (Lz77::isLz77(bytes, (size_t)magic.size()))
+        return Codec::Lz77;
+    if (Fse::isFse(bytes, (size_t)magic.size()))
+        return Codec::Fse;
+    return Codec::Huffman;
+}
+
+// Original size; every coder checks it against what the file can hold, so it is safe to allocate
+static bool decodedSize(Codec codec, const uint8_t *in, size_t size, uint64_t &originalSize)
+{
+    switch (codec) {
+    case Codec::Lz77: return Lz77::decompressedSize(in, size, originalSize);
+    case Codec::Fse: return Fse::decompressedSize(in, size, originalSize);
+    default: return Huffman::decompressedSize(in, size, originalSize);
+    }
+}
+
+static bool decodeTo(Codec codec, const uint8_t *in, size_t size, uint8_t *out, size_t outSize, JobProgress &progress)
+{
+    switch (codec) {
+    case Codec::Lz77: return Lz77::decompressTo(in, size, out, outSize, 0, &progress);
+    case Codec::Fse: return Fse::decompressTo(in, size, out, outSize, 0, &progress);
+    default: return Huffman::decompressTo(in, size, out, outSize, 0, &progress);
+    }
+}
+
+static bool decodeStream(Codec codec, Huffman::InputStream &in, Huffman::OutputStream &out, JobProgress &progress)
+{
+    switch (codec) {
+    case Codec::Lz77: return Lz77::decompressStream(in, out, &progress);
+    case Codec::Fse: return Fse::decompressStream(in, out, &progress);
+    default: return Huffman::decompressStream(in, out, &progress);
+    }
+}
+
+static bool decodeRange(Codec codec, const uint8_t *in, size_t size, uint64_t offset, size_t length,
+                        std::vector<uint8_t> &out)
+{
+    switch (codec) {
+    case Codec::Lz77: return Lz77::decompressRange(in, size, offset, length, out);
+    case Codec::Fse: return Fse::decompressRange(in, size, offset, length, out);
+    default: return Huffman::decompressRange(in, size, offset, length, out);
+    }
+}
+
+bool readRange(const QString &path, qint64 offset, qint64 length, QByteArray &out)
+{
+    QFile file(path);
+    // A QByteArray holds at most INT_MAX bytes; longer ranges are read in pieces
+    if (offset < 0 || length < 0 || length > std::numeric_limits<int>::max() || !file.open(QFile::ReadOnly))
+        return false;
+
+    // The index (or block headers) lives at both ends of the file, so the coder
+    // needs all of it in memory; a mapping only pages in what is touched
+    const Codec codec = codecOf(file.peek(4));
+    QByteArray whole;
+    const uchar *mapped = file.map(0, file.size());
+    const uchar *data = mapped;
+    if (!mapped) {
+        whole = file.readAll();
+        data = reinterpret_cast<const uchar *>(whole.constData());
+    }
+    std::vector<uint8_t> range;
+    bool ok = decodeRange(codec, data, (size_t)file.size(), (uint64_t)offset, (size_t)length, range);
+    if (mapped)
+        file.unmap(const_cast<uchar *>(mapped));
+    if (ok)
+        out = QByteArray(reinterpret_cast<const char *>(range.data()), int(range.size())); // at most length
+    return ok;
+}
+
+static bool verifyData(Codec codec, const uint8_t *in, size_t size, int threads, JobProgress &progress)
+{
+    switch (codec) {
+    case Codec::Lz77: return Lz77::verify(in, size, threads, &progress);
+    case Codec::Fse: return Fse::verify(in, size, threads, &progress);
+    default: return Huffman::verify(in, size, threads, &progress);
+    }
+}
+
+// Sink for verifying a file that cannot be mapped: decoded output is dropped
+class NullOutput : public Huffman::OutputStream
+{
+public:
+    bool write(const uint8_t *, size_t) override { return true; }
+};
+
+JobResult verifyFile(const QString &path, JobProgress &progress, int threads)
+{
+    JobResult result;
+    result.inputPath = path;
+    result.inputSize = QFileInfo(path).size();
+    result.outputSize = result.inputSize;
+    progress.report(0);
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        result.error = "❌ Cannot open input file for reading.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    // Decoding checks the block and file CRCs; nothing is written
+    const Codec codec = codecOf(file.peek(4));
+    bool ok;
+    const uchar *mapped = file.map(0, file.size());
+    if (mapped) {
+        ok = verifyData(codec, mapped, (size_t)file.size(), threads, progress);
+        file.unmap(const_cast<uchar *>(mapped));
+    } else {
+        DeviceInput input(file);
+        NullOutput output;
+        ok = decodeStream(codec, input, output, progress);
+    }
+
+    if (!ok) {
+        result.status = progress.isCancelled() ? JobResult::Cancelled : JobResult::Failed;
+        result.error = "❌ Verification failed!\n\nThe file is corrupted or not a valid .huff file.";
+        return result;
+    }
+    result.status = JobResult::Succeeded;
+    return result;
+}
+
+JobResult decompressFile(const QString &path, const QString &outputDir, JobProgress &progress)
+{
+    QFileInfo fileInfo(path);
+    JobResult result;
+    result.inputPath = path;
+    result.inputSize = fileInfo.size();
+    result.outputSize = result.inputSize;
+    progress.report(0); // the original size is only known once the header is read
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        result.error = "❌ Cannot open input file for reading.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    // Determine output file path - remove .huff extension and restore original extension
+    // The compressed file is saved as "originalname.extension.huff"
+    // We need to remove ".huff" to get back "originalname.extension"
+    QString fileName = fileInfo.fileName(); // e.g., "document.pdf.huff"
+    QString baseFileName;
+
+    // Remove ".huff" extension explicitly
+    if (fileName.endsWith(".huff", Qt::CaseInsensitive)) {
+        baseFileName = fileName.left(fileName.length() - 5); // Remove ".huff" (5 characters)
+    } else {
+        // Fallback: use baseName() if the explicit removal didn't work
+        baseFileName = fileInfo.baseName();
+    }
+
+    // Use the given save location if set, otherwise the file's directory
+    QString dir = outputDir.isEmpty() ? fileInfo.absolutePath() : outputDir;
+
+    // Decode straight to disk under a temporary name; the final name may depend on the content
+    QString partPath = QDir(dir).filePath(baseFileName + ".part");
+    QFile outFile(partPath);
+    // Read access too: a shared writable mapping needs it
+    if (!outFile.open(QFile::ReadWrite | QFile::Truncate)) {
+        result.error = "❌ Cannot open output file for writing.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    // Decompress (coder told apart by the magic): mapped input decoded straight into the
+    // pre-sized, mapped output file; if either mapping is unavailable, stream with
+    // bounded memory instead
+    bool ok = false;
+    bool decoded = false;
+    QByteArray head;
+    const Codec codec = codecOf(file.peek(4));
+    const uchar *mapped = file.map(0, file.size());
+    if (mapped) {
+        uint64_t originalSize = 0;
+        if (decodedSize(codec, mapped, (size_t)file.size(), originalSize) &&
+            originalSize > 0 && outFile.resize((qint64)originalSize)) {
+            uchar *target = outFile.map(0, (qint64)originalSize);
+            if (target) {
+                ok = decodeTo(codec, mapped, (size_t)file.size(), target, (size_t)originalSize, progress);
+                head = QByteArray(reinterpret_cast<const char *>(target), (int)qMin<uint64_t>(originalSize, 4));
+                outFile.unmap(target);
+                decoded = true;
+            }
+        }
+        file.unmap(const_cast<uchar *>(mapped));
+    }
+    if (!decoded) {
+        outFile.resize(0);
+        outFile.seek(0);
+        DeviceInput input(file);
+        DeviceOutput output(outFile);
+        ok = decodeStream(codec, input, output, progress);
+        head = output.firstBytes();
+    }
+    result.outputSize = outFile.size();
+    outFile.close();
+    file.close();
+
+    if (!ok) {
+        QFile::remove(partPath);
+        result.outputSize = result.inputSize;
+        result.status = progress.isCancelled() ? JobResult::Cancelled : JobResult::Failed;
+        result.error = "❌ Decompression failed!\n\nThe file may be corrupted or not a valid .huff file.";
+        return result;
+    }
+
+    // Verify that the baseFileName has an extension
+    // If not, try to detect from file content
+    QFileInfo baseFileInfo(baseFileName);
+    if (baseFileInfo.suffix().isEmpty()) {
+        // No extension found, try to detect from magic bytes
+        if (head.size() >= 4 && head.startsWith("%PDF")) {
+            // PDF magic bytes: %PDF
+            baseFileName += ".pdf";
+        } else {
+            baseFileName += ".txt";
+        }
+    }
+
+    // Construct the full output path using QDir to ensure proper path separators
+    QString outPath = QDir(dir).filePath(baseFileName);
+    QFile::remove(outPath);
+    if (!QFile::rename(partPath, outPath)) {
+        QFile::remove(partPath);
+        result.error = "❌ Cannot open output file for writing.\n\nPlease check file permissions.";
+        return result;
+    }
+
+    result.outPath = outPath;
+    result.status = JobResult::Succeeded;
+    return result;
+}
+
+// =============================================================
+// =========================== BATCH ============================
+// =============================================================
+QStringList collectFiles(const QString &dir)
+{
+    QStringList files;
+    QDirIterator it(dir, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFileInfo info(it.next());
+        // Outputs of earlier runs ("x_png_compressed.jpg", "x.pdf.huff", or a leftover
+        // "x_png_compressed.part.jpg") are not inputs
+        QString name = info.completeBaseName();
+        if (name.endsWith("_compressed") || name.endsWith("_compressed.part") || fileTypeFor(info.suffix()).isEmpty())
+            continue;
+        files.append(info.absoluteFilePath());
+    }
+    files.sort();
+    return files;
+}
+
+BatchSummary compressBatch(const QStringList &paths, const QString &outputDir, const QString &baseDir,
+                           int workers, BatchProgress &progress)
+{
+    QElapsedTimer clock;
+    clock.start();
+    std::vector<JobResult> results(paths.size());
+
+    // Where each output goes: sub-folders of the selected directory are mirrored below the
+    // save location. Inputs that would share an output path (x.txt from two folders given
+    // together, say) would be written by two workers at once, so only the first is
+    // compressed and the others fail with the clash named.
+    std::vector<QString> dirs(paths.size());
+    std::vector<int> clashesWith(paths.size(), -1);
+    QHash<QString, int> outputs;
+    for (int i = 0; i < paths.size(); ++i) {
+        QFileInfo info(paths[i]);
+        QString dir = outputDir.isEmpty() ? info.absolutePath() : outputDir;
+        if (!outputDir.isEmpty() && !baseDir.isEmpty())
+            dir = QDir(outputDir).filePath(QDir(baseDir).relativeFilePath(info.absolutePath()));
+        dirs[i] = dir;
+        QString key = QDir::cleanPath(QDir(dir).absoluteFilePath(outputNameFor(info, fileTypeFor(info.suffix()))));
+#ifdef Q_OS_WIN
+        key = key.toLower(); // names differing only in case are the same file
+#endif
+        auto it = outputs.constFind(key);
+        if (it != outputs.constEnd())
+            clashesWith[i] = it.value();
+        else
+            outputs.insert(key, i);
+    }
+
+    // Parallelism comes from the files, so each one runs its engine on a
+    // single thread; a worker owns one file (and its buffers) at a time
+    Parallel::forEach(paths.size(), workers, [&](size_t i) {
+        const QString &path = paths[(int)i];
+        QFileInfo info(path);
+        JobResult &result = results[i];
+        result.inputPath = path;
+        result.fileType = fileTypeFor(info.suffix());
+        result.inputSize = info.size();
+
+        if (progress.isCancelled()) {
+            result.status = JobResult::Cancelled;
+        } else if (clashesWith[i] >= 0) {
+            result.status = JobResult::Failed;
+            result.error = QString("❌ Same output file as %1; not compressed.").arg(paths[clashesWith[i]]);
+        } else if (result.inputSize == 0) {
+            result.status = JobResult::NotSmaller; // nothing to compress
+        } else {
+            QDir().mkpath(dirs[i]);
+            JobProgress fileProgress;
+            fileProgress.setParent(&progress);
+            result = compressFile(path, dirs[i], fileProgress, 1);
+            fileProgress.report(result.inputSize); // count the whole file, whatever the engine reported last
+        }
+        progress.fileFinished();
+    });
+
+    BatchSummary summary;
+    for (int i = 0; i < paths.size(); ++i) {
+        const JobResult &result = results[i];
+        switch (result.status) {
+        case JobResult::Succeeded:
+            summary.succeeded++;
+            summary.originalBytes += result.inputSize;
+            summary.compressedBytes += result.outputSize;
+            summary.records.append({result.fileType, paths[i], result.inputSize, result.outputSize});
+            break;
+        case JobResult::NotSmaller:
+            summary.skipped++;
+            break;
+        case JobResult::Cancelled:
+            summary.cancelled++;
+            break;
+        case JobResult::Failed:
+            summary.failed++;
+            summary.failures.append(QFileInfo(paths[i]).fileName() + ": " + result.errorSummary());
+            break;
+        }
+    }
+    summary.elapsedMs = clock.elapsed();
+    summary.results = QVector<JobResult>(results.begin(), results.end());
+    return summary;
+}
+
+} // namespace CompressionJob
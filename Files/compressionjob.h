@@ -0,0 +1,135 @@
+#ifndef COMPRESSIONJOB_H
+#define COMPRESSIONJOB_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include "huffman.h"
+
+/*
+  COMPRESSION JOB - file-level engine shared by the GUI and the filecompress CLI:
+  - compressFile/decompressFile hold the dispatch (type detection, LZ77/FSE/Huffman, OpenCV, output
+    naming, the size-reduction check) and never touch widgets; the windows run them on a
+    QtConcurrent pool thread, the CLI calls them directly (see engine.pri)
+  - Progress is published through atomics in JobProgress; the window polls them from a
+    timer, so a fast engine never floods the event loop with signals
+  - Cancellation is cooperative: the engine sees cancel() at its next slice, block or
+    frame, stops, and the partial output file is removed
+  - Batches: a bounded pool (Parallel::forEach) takes files off a shared queue; each file
+    gets its own JobProgress chained to the batch one, and the results come back as one
+    BatchSummary so the window can show a single report and record everything at once
+*/
+
+// Shared between the GUI thread (reads, cancels) and the job thread (writes)
+class JobProgress : public Huffman::Progress
+{
+public:
+    // Called by the window before a job starts (clears a previous cancel)
+    void reset(qint64 totalBytes);
+    void cancel() { cancelRequested = true; }
+    bool isCancelled() const { return cancelRequested || (parent && parent->isCancelled()); }
+
+    // Per-file progress inside a batch: byte deltas are added to the parent, and
+    // cancelling the parent cancels this job too
+    void setParent(JobProgress *batch) { parent = batch; }
+
+    // Bytes processed so far on the uncompressed side, and the expected total (0 = unknown)
+    qint64 processed() const { return done; }
+    qint64 total() const { return expected; }
+
+    // Records progress; returns false once cancel() was called
+    bool report(qint64 processedBytes, qint64 totalBytes = 0);
+    bool update(uint64_t processedBytes, uint64_t totalBytes) override;
+
+private:
+    std::atomic<qint64> done{0};
+    std::atomic<qint64> expected{0};
+    std::atomic<bool> cancelRequested{false};
+    JobProgress *parent = nullptr;
+};
+
+// Batch-wide progress: bytes through JobProgress, plus how many files are finished
+class BatchProgress : public JobProgress
+{
+public:
+    void resetBatch(qint64 totalBytes, int totalFiles);
+    void fileFinished() { ++finished; }
+    int filesDone() const { return finished; }
+    int filesTotal() const { return fileCount; }
+
+private:
+    std::atomic<int> finished{0};
+    std::atomic<int> fileCount{0};
+};
+
+struct JobResult
+{
+    enum Status { Succeeded, NotSmaller, Failed, Cancelled };
+
+    Status status = Failed;
+    QString inputPath;
+    QString fileType;     // compression: "Image", "Video", "PDF", "Text" (empty when unsupported)
+    QString outPath;      // only kept on success
+    qint64 inputSize = 0;
+    qint64 outputSize = 0;
+    int quality = 0;      // lossy paths only
+    QString error;        // user-facing reason when Failed
+
+    // First line of error without decoration, for lists and logs
+    QString errorSummary() const;
+};
+
+// One compressed file, as History/Dashboard/Visualizer record it
+struct BatchRecord
+{
+    QString fileType;
+    QString filePath;
+    qint64 originalSize = 0;
+    qint64 compressedSize = 0;
+};
+
+struct BatchSummary
+{
+    QVector<BatchRecord> records;   // succeeded files, in queue order
+    int succeeded = 0;
+    int skipped = 0;                // empty, or output not smaller
+    int failed = 0;
+    int cancelled = 0;              // failed to start or stopped by cancel()
+    qint64 originalBytes = 0;       // succeeded files only
+    qint64 compressedBytes = 0;
+    qint64 elapsedMs = 0;
+    QStringList failures;           // "file: reason", for the report
+    QVector<JobResult> results;     // one per input path, same order
+};
+
+namespace CompressionJob {
+
+// "Image", "Video", "PDF", "Text" for the extensions the app handles, empty otherwise
+QString fileTypeFor(const QString &extension);
+
+// Output goes to outputDir, or next to the input when outputDir is empty.
+// threads: engine worker threads for this file (0 = one per core)
+JobResult compressFile(const QString &path, const QString &outputDir, JobProgress &progress, int threads = 0);
+JobResult decompressFile(const QString &path, const QString &outputDir, JobProgress &progress);
+// Bytes [offset, offset + length) of a compressed file's original (fewer at its end),
+// decoding only the blocks that cover them, e.g. to preview the start of a large file;
+// length may not exceed INT_MAX, the most a QByteArray holds
+bool readRange(const QString &path, qint64 offset, qint64 length, QByteArray &out);
+// Decodes without writing anything and checks the block and file CRCs the coders
+// store; Succeeded when intact, Failed with a reason otherwise
+JobResult verifyFile(const QString &path, JobProgress &progress, int threads = 0);
+
+// Supported files under dir (recursive), skipping outputs of earlier runs
+QStringList collectFiles(const QString &dir);
+
+// Compresses every path on up to `workers` threads (0 = one per core). Files
+// under baseDir keep their relative folder below outputDir; a file whose output
+// path an earlier one already takes fails instead of overwriting it.
+BatchSummary compressBatch(const QStringList &paths, const QString &outputDir, const QString &baseDir,
+                           int workers, BatchProgress &progress);
+
+} // namespace CompressionJob
+
+#endif // COMPRESSIONJOB_H
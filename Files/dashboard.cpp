@@ -589,6 +589,26 @@ void DashboardWindow::refreshStatsDisplay()
 }
 
 void DashboardWindow::updateStats(qint64 originalSize, qint64 compressedSize)
+{
+    accumulateStats(originalSize, compressedSize);
+    
+    // Save stats
+    saveStats();
+    
+    // Refresh display
+    refreshStatsDisplay();
+}
+
+void DashboardWindow::addBatchStats(const QVector<BatchRecord> &records)
+{
+    for (const BatchRecord &record : records) {
+        accumulateStats(record.originalSize, record.compressedSize);
+    }
+    saveStats();
+    refreshStatsDisplay();
+}
+
+void DashboardWindow::accumulateStats(qint64 originalSize, qint64 compressedSize)
 {
     // Increment total files
     totalFilesProcessed++;
@@ -604,12 +624,6 @@ void DashboardWindow::updateStats(qint64 originalSize, qint64 compressedSize)
     if (compressionRatio > 0) {
         totalCompressionRatio += compressionRatio;
     }
-    
-    // Save stats
-    saveStats();
-    
-    // Refresh display
-    refreshStatsDisplay();
 }
 
 void DashboardWindow::resizeEvent(QResizeEvent *event) {
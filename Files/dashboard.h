@@ -10,6 +10,8 @@
 #include <QGraphicsOpacityEffect>
 #include <QPropertyAnimation>
 #include <QResizeEvent>
+#include <QVector>
+#include "compressionjob.h"
 
 class DashboardWindow : public QWidget
 {
@@ -21,6 +23,8 @@ public:
     
     // Public method to update stats
     void updateStats(qint64 originalSize, qint64 compressedSize);
+    // Batch version: accumulates every record, then saves and refreshes once
+    void addBatchStats(const QVector<BatchRecord> &records);
 
 signals:
     void navigateToDashboard();
@@ -43,6 +47,7 @@ private:
     void applyStyles();
     void setupAnimations();
     void loadStats();
+    void accumulateStats(qint64 originalSize, qint64 compressedSize);
     void saveStats();
     void refreshStatsDisplay();
     void updateResponsiveSizes();
@@ -1,6 +1,6 @@
 #include "decompression.h"
 #include "theme.h"
-#include "huffman.h"
+#include "compressionjob.h"
 
 #include <QDebug>
 #include <QFont>
@@ -26,6 +26,7 @@
 #include <QDialogButtonBox>
 #include <QSizePolicy>
 #include "styledmessagebox.h"
+#include <QtConcurrent/QtConcurrentRun>
 
 DecompressWindow::DecompressWindow(QWidget *parent)
     : QWidget(parent)
@@ -104,18 +105,33 @@ DecompressWindow::DecompressWindow(QWidget *parent)
             return;
         }
 
-        startButton->setEnabled(false);
-        QApplication::processEvents();
-
+        // Returns immediately; the buttons come back when the background job finishes
         decompressSelectedFile(selectedFilePath);
+    });
 
-        startButton->setEnabled(true);
+    connect(previewButton, &QPushButton::clicked, this, &DecompressWindow::previewSelectedFile);
+
+    // --- Background job plumbing ---
+    jobWatcher = new QFutureWatcher<JobResult>(this);
+    connect(jobWatcher, &QFutureWatcher<JobResult>::finished, this, &DecompressWindow::decompressionJobFinished);
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(16); // ~60 fps, independent of how often the engine reports
+    connect(progressTimer, &QTimer::timeout, this, &DecompressWindow::updateJobProgress);
+    connect(cancelButton, &QPushButton::clicked, this, [=]() {
+        jobProgress.cancel();
+        cancelButton->setEnabled(false);
+        progressLabel->setText("Cancelling...");
     });
 
     // Navigation connections are now in setupSidebar()
 }
 
-DecompressWindow::~DecompressWindow() = default;
+DecompressWindow::~DecompressWindow()
+{
+    // The job thread writes into jobProgress; stop it before the window goes away
+    jobProgress.cancel();
+    jobWatcher->waitForFinished();
+}
 
 // =============================================================
 // ====================== UI SETUP METHODS =======================
@@ -389,9 +405,70 @@ void DecompressWindow::setupContentArea()
     QFont startFont("Segoe UI", 18, QFont::Bold);
     startButton->setFont(startFont);
     buttonLayout->addWidget(startButton);
+    buttonLayout->addSpacing(16);
+    previewButton = new QPushButton("👁 Preview First 64 KB");
+    previewButton->setMinimumWidth(220);
+    previewButton->setMaximumWidth(360);
+    previewButton->setFixedHeight(56);
+    previewButton->setCursor(Qt::PointingHandCursor);
+    previewButton->setFont(QFont("Segoe UI", 13, QFont::Bold));
+    buttonLayout->addWidget(previewButton);
     buttonLayout->addStretch();
     
     contentLayout->addLayout(buttonLayout);
+    contentLayout->addSpacing(20);
+
+    // Progress row (visible only while a job runs): bar, bytes/throughput, cancel
+    progressContainer = new QWidget();
+    progressContainer->setObjectName("ProgressCard");
+    QVBoxLayout *progressLayout = new QVBoxLayout(progressContainer);
+    progressLayout->setContentsMargins(22, 12, 22, 12);
+    progressLayout->setSpacing(10);
+
+    QHBoxLayout *progressRow = new QHBoxLayout();
+    progressRow->setSpacing(15);
+    progressBar = new QProgressBar();
+    progressBar->setTextVisible(false);
+    progressBar->setFixedHeight(14);
+    progressBar->setStyleSheet(R"(
+        QProgressBar {
+            background: rgba(14, 165, 233, 0.15);
+            border: 1px solid rgba(14, 165, 233, 0.5);
+            border-radius: 7px;
+        }
+        QProgressBar::chunk {
+            background: qlineargradient(x1:0, y1:0, x2:1, y2:0, stop:0 #0ea5e9, stop:1 #38bdf8);
+            border-radius: 6px;
+        }
+    )");
+    progressRow->addWidget(progressBar, 1);
+
+    cancelButton = new QPushButton("✖ Cancel");
+    cancelButton->setFixedHeight(40);
+    cancelButton->setCursor(Qt::PointingHandCursor);
+    cancelButton->setFont(QFont("Segoe UI", 12, QFont::Bold));
+    cancelButton->setStyleSheet(R"(
+        QPushButton {
+            background: rgba(239, 68, 68, 0.2);
+            color: #fecaca;
+            border: 2px solid rgba(239, 68, 68, 0.6);
+            border-radius: 12px;
+            padding: 6px 18px;
+        }
+        QPushButton:hover { background: rgba(239, 68, 68, 0.35); }
+        QPushButton:disabled { color: rgba(254, 202, 202, 0.5); border-color: rgba(239, 68, 68, 0.25); }
+    )");
+    progressRow->addWidget(cancelButton);
+    progressLayout->addLayout(progressRow);
+
+    progressLabel = new QLabel();
+    progressLabel->setFont(QFont("Segoe UI", 12));
+    progressLabel->setStyleSheet("color: #bae6fd; background: transparent;");
+    progressLabel->setAlignment(Qt::AlignCenter);
+    progressLayout->addWidget(progressLabel);
+
+    progressContainer->setVisible(false);
+    contentLayout->addWidget(progressContainer);
     contentLayout->addStretch(1);
 }
 
@@ -644,6 +721,7 @@ void DecompressWindow::applyStyles()
         )").arg(colors.buttonBg, colors.primaryDark, colors.buttonBorder,
                 colors.primary, colors.primaryDark, colors.primaryLight, colors.primaryDark);
         selectSaveLocationButton->setStyleSheet(saveLocationButtonStyle);
+        if (previewButton) previewButton->setStyleSheet(saveLocationButtonStyle);
     }
 }
 
@@ -690,8 +768,6 @@ void DecompressWindow::setupAnimations()
 void DecompressWindow::decompressSelectedFile(const QString &path) {
     QFileInfo fileInfo(path);
     QString extension = fileInfo.suffix().toLower();
-
-    QLocale locale;
     qint64 compressedSize = fileInfo.size();
 
     // Check if it's a .huff file
@@ -705,98 +781,121 @@ void DecompressWindow::decompressSelectedFile(const QString &path) {
         return;
     }
 
-    QFile file(path);
-    if (!file.open(QFile::ReadOnly)) {
+    if (compressedSize == 0) {
         QWidget *parentWindow = this->window();
-        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                     "❌ Cannot open input file for reading.\n\nPlease check file permissions.", QMessageBox::Critical);
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Empty File",
+                                     "⚠️ The selected file is empty.\n\nNothing to decompress.", QMessageBox::Warning);
         msgBox->exec();
         delete msgBox;
+        // Initialize size labels
+        compressedSizeLabel->setText("--");
+        decompressedSizeLabel->setText("--");
         return;
     }
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    std::vector<uint8_t> compressedBytes(data.begin(), data.end());
+    // --- RUN THE ENGINE OFF THE GUI THREAD ---
+    // decompressionJobFinished() reports the result back on the GUI thread.
+    jobPath = path;
+    jobProgress.reset(0);
+    QString outputDir = saveLocationPath;
+    setJobRunning(true);
+    jobWatcher->setFuture(QtConcurrent::run([this, path, outputDir]() {
+        return CompressionJob::decompressFile(path, outputDir, jobProgress);
+    }));
+}
 
-    if (compressedBytes.empty()) {
-        QWidget *parentWindow = this->window();
-        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ Empty File",
-                                     "⚠️ The selected file is empty.\n\nNothing to decompress.", QMessageBox::Warning);
+void DecompressWindow::previewSelectedFile() {
+    QWidget *parentWindow = this->window();
+    if (selectedFilePath.isEmpty()) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "⚠️ No File Selected",
+                                 "⚠️ Please select a file first.", QMessageBox::Warning);
         msgBox->exec();
         delete msgBox;
-        // Initialize size labels
-    compressedSizeLabel->setText("--");
-    decompressedSizeLabel->setText("--");
         return;
     }
 
-    // Decompress using Huffman
-    std::vector<uint8_t> decompressedBytes;
-    bool ok = Huffman::decompressBytes(compressedBytes, decompressedBytes);
-
-    if (!ok) {
-        QWidget *parentWindow = this->window();
-        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                     "❌ Huffman Decompression failed!\n\nThe file may be corrupted or not a valid .huff file.", QMessageBox::Critical);
+    // Only the blocks holding the first 64 KB are decoded: quick even for huge files
+    const qint64 previewBytes = 64 * 1024;
+    QByteArray head;
+    if (!CompressionJob::readRange(selectedFilePath, 0, previewBytes, head)) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Preview Failed",
+                                 "❌ Cannot read the start of this file.\n\nIt may be damaged or not a .huff file.",
+                                 QMessageBox::Critical);
         msgBox->exec();
         delete msgBox;
-        updateDecompressionChart(compressedSize, compressedSize);
         return;
     }
 
-    qint64 decompressedSize = (qint64)decompressedBytes.size();
+    QMessageBox *msgBox = createStyledMessageBox(parentWindow, "👁 Preview",
+                             QString("👁 First %1 of <b>%2</b>.<br><br>Show Details for the content.")
+                                 .arg(formatFileSize(head.size()), QFileInfo(selectedFilePath).fileName().toHtmlEscaped()),
+                             QMessageBox::Information);
+    msgBox->setDetailedText(QString::fromUtf8(head));
+    msgBox->exec();
+    delete msgBox;
+}
 
-    // Determine output file path - remove .huff extension and restore original extension
-    // The compressed file is saved as "originalname.extension.huff"
-    // We need to remove ".huff" to get back "originalname.extension"
-    QString fileName = fileInfo.fileName(); // e.g., "document.pdf.huff"
-    QString baseFileName;
-    
-    // Remove ".huff" extension explicitly
-    if (fileName.endsWith(".huff", Qt::CaseInsensitive)) {
-        baseFileName = fileName.left(fileName.length() - 5); // Remove ".huff" (5 characters)
+void DecompressWindow::setJobRunning(bool running) {
+    startButton->setEnabled(!running);
+    previewButton->setEnabled(!running);
+    addFileButton->setEnabled(!running);
+    progressContainer->setVisible(running);
+    cancelButton->setEnabled(running);
+    if (running) {
+        progressBar->setRange(0, 0);
+        progressLabel->setText("Starting...");
+        jobClock.start();
+        progressTimer->start();
     } else {
-        // Fallback: use baseName() if the explicit removal didn't work
-        baseFileName = fileInfo.baseName();
+        progressTimer->stop();
     }
-    
-    // Verify that the baseFileName has an extension
-    // If not, try to detect from file content
-    QFileInfo baseFileInfo(baseFileName);
-    if (baseFileInfo.suffix().isEmpty()) {
-        // No extension found, try to detect from magic bytes
-        if (decompressedBytes.size() >= 4) {
-            if (decompressedBytes[0] == 0x25 && decompressedBytes[1] == 0x50 && 
-                decompressedBytes[2] == 0x44 && decompressedBytes[3] == 0x46) {
-                // PDF magic bytes: %PDF
-                baseFileName += ".pdf";
-            } else {
-                baseFileName += ".txt";
-            }
-        } else {
-            baseFileName += ".txt";
-        }
+}
+
+// Polled by progressTimer (~60 Hz): reads the job's atomics, never blocks
+void DecompressWindow::updateJobProgress() {
+    qint64 done = jobProgress.processed();
+    qint64 total = jobProgress.total();
+    double seconds = jobClock.elapsed() / 1000.0;
+
+    if (total > 0) {
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(static_cast<int>(1000.0 * qMin(done, total) / total));
+    } else {
+        progressBar->setRange(0, 0); // busy indicator until the size is known
     }
-    
-    // Use selected save location if set, otherwise use file's directory
-    QString outputDir = saveLocationPath.isEmpty() ? fileInfo.absolutePath() : saveLocationPath;
-    // Construct the full output path using QDir to ensure proper path separators
-    QString outPath = QDir(outputDir).filePath(baseFileName);
+    QString rate = (seconds > 0.05 && done > 0) ? formatFileSize(static_cast<qint64>(done / seconds)) + "/s" : "--";
+    progressLabel->setText(QString("%1 / %2  •  %3")
+                               .arg(formatFileSize(done))
+                               .arg(total > 0 ? formatFileSize(total) : QString("?"))
+                               .arg(rate));
+}
 
-    // Write decompressed file
-    QFile outFile(outPath);
-    if (!outFile.open(QFile::WriteOnly)) {
-        QWidget *parentWindow = this->window();
-        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error",
-                                     "❌ Cannot open output file for writing.\n\nPlease check file permissions.", QMessageBox::Critical);
+void DecompressWindow::decompressionJobFinished() {
+    setJobRunning(false);
+    JobResult result = jobWatcher->result();
+    QString path = jobPath;
+    qint64 compressedSize = result.inputSize;
+    qint64 decompressedSize = result.outputSize;
+    QWidget *parentWindow = this->window();
+
+    if (result.status == JobResult::Cancelled) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "ℹ️ Decompression Cancelled",
+                                     "ℹ️ Decompression was cancelled.\n\nNo output file was kept.", QMessageBox::Information);
+        msgBox->exec();
+        delete msgBox;
+        updateDecompressionChart(compressedSize, compressedSize);
+        return;
+    }
+
+    if (result.status != JobResult::Succeeded) {
+        QMessageBox *msgBox = createStyledMessageBox(parentWindow, "❌ Error", result.error, QMessageBox::Critical);
         msgBox->exec();
         delete msgBox;
+        updateDecompressionChart(compressedSize, compressedSize);
         return;
     }
-    outFile.write(reinterpret_cast<const char*>(decompressedBytes.data()), decompressedSize);
-    outFile.close();
+
+    QString outPath = result.outPath;
 
     // Determine file type from extension
     QString fileType = "Data";
@@ -923,6 +1022,15 @@ void DecompressWindow::updateResponsiveSizes() {
         selectSaveLocationButton->setFont(f);
     }
 
+    if (previewButton) {
+        previewButton->setMinimumWidth(qBound(180, static_cast<int>(220 * scale), 340));
+        previewButton->setMaximumWidth(qBound(240, static_cast<int>(340 * scale), 400));
+        previewButton->setFixedHeight(qBound(48, static_cast<int>(56 * scale), 68));
+        QFont f = previewButton->font();
+        f.setPointSize(qBound(12, static_cast<int>(13 * scale), 15));
+        previewButton->setFont(f);
+    }
+
     if (filePathLabel) {
         QFont f = filePathLabel->font();
         f.setPointSize(qBound(13, static_cast<int>(17 * scale), 20));
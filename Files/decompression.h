@@ -9,7 +9,12 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QResizeEvent>
+#include <QProgressBar>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <vector>
+#include "compressionjob.h"
 
 // QtCharts headers
 #include <QtCharts/QChartView>
@@ -37,6 +42,11 @@ signals:
 private slots:
     // Slot for the main decompression logic
     void decompressSelectedFile(const QString &path);
+    // First 64 KB of the selected file's original, decoded without a full decompression
+    void previewSelectedFile();
+    // Background job: progress polling and completion on the GUI thread
+    void updateJobProgress();
+    void decompressionJobFinished();
 
 public:
     void applyTheme();
@@ -51,6 +61,7 @@ private:
     void setupAnimations();
     void updateDecompressionChart(qint64 compressedSize, qint64 decompressedSize);
     void updateResponsiveSizes();
+    void setJobRunning(bool running);
 
     // Core UI Components
     QWidget *mainCentralWidget;
@@ -72,6 +83,7 @@ private:
     QPushButton *addFileButton;
     QLabel *filePathLabel;
     QPushButton *startButton;
+    QPushButton *previewButton;
     QString selectedFilePath;
     QPushButton *selectSaveLocationButton;
     QLabel *saveLocationLabel;
@@ -82,6 +94,17 @@ private:
     QChartView *chartView;
     QLabel *compressedSizeLabel;
     QLabel *decompressedSizeLabel;
+
+    // --- BACKGROUND JOB (progress + cancel) ---
+    QWidget *progressContainer;
+    QProgressBar *progressBar;
+    QLabel *progressLabel;
+    QPushButton *cancelButton;
+    QTimer *progressTimer;
+    QElapsedTimer jobClock;
+    QFutureWatcher<JobResult> *jobWatcher;
+    JobProgress jobProgress;
+    QString jobPath;
 };
 
 #endif // DECOMPRESSION_H
@@ -0,0 +1,49 @@
+#ifndef DEVICESTREAM_H
+#define DEVICESTREAM_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include "huffman.h"
+
+// Adapters that let the Huffman streaming API read from / write to any
+// QIODevice (QFile, QBuffer, sockets) without loading the whole file.
+
+class DeviceInput : public Huffman::InputStream
+{
+public:
+    explicit DeviceInput(QIODevice &device) : dev(device), start(device.pos()) {}
+
+    size_t read(uint8_t *buf, size_t maxSize) override {
+        qint64 n = dev.read(reinterpret_cast<char *>(buf), static_cast<qint64>(maxSize));
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    bool rewind() override {
+        return !dev.isSequential() && dev.seek(start);
+    }
+
+private:
+    QIODevice &dev;
+    qint64 start;
+};
+
+class DeviceOutput : public Huffman::OutputStream
+{
+public:
+    explicit DeviceOutput(QIODevice &device) : dev(device) {}
+
+    bool write(const uint8_t *data, size_t size) override {
+        // Keep the first bytes so callers can sniff the content type afterwards
+        if (head.size() < 4)
+            head.append(reinterpret_cast<const char *>(data), static_cast<int>(qMin<size_t>(size, 4 - head.size())));
+        return dev.write(reinterpret_cast<const char *>(data), static_cast<qint64>(size)) == static_cast<qint64>(size);
+    }
+
+    const QByteArray &firstBytes() const { return head; }
+
+private:
+    QIODevice &dev;
+    QByteArray head;
+};
+
+#endif // DEVICESTREAM_H
@@ -0,0 +1,43 @@
+# Compression engine: Huffman, FSE and LZ77 containers, OpenCV media paths and the file-level
+# job dispatch. No widgets (QtCore only), so the GUI (Files.pro) and the
+# headless command-line tool (cli/filecompress.pro) build the same sources.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/avijoin.cpp \
+    $$PWD/blockformat.cpp \
+    $$PWD/checksum.cpp \
+    $$PWD/compressionjob.cpp \
+    $$PWD/fse.cpp \
+    $$PWD/histogram.cpp \
+    $$PWD/huffman.cpp \
+    $$PWD/imagecom.cpp \
+    $$PWD/lz77.cpp
+
+HEADERS += \
+    $$PWD/avijoin.h \
+    $$PWD/blockformat.h \
+    $$PWD/checksum.h \
+    $$PWD/compressionjob.h \
+    $$PWD/devicestream.h \
+    $$PWD/fse.h \
+    $$PWD/histogram.h \
+    $$PWD/huffman.h \
+    $$PWD/imagecom.h \
+    $$PWD/lz77.h \
+    $$PWD/parallel.h
+
+win32 {
+    INCLUDEPATH += C:/opencv/build_mingw/include
+    LIBS += -LC:/opencv/build_mingw/x64/mingw/lib \
+        -lopencv_core455 \
+        -lopencv_imgcodecs455 \
+        -lopencv_highgui455 \
+        -lopencv_imgproc455\
+        -lopencv_videoio455 \
+        -lopencv_video455
+} else {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4
+}
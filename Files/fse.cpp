@@ -0,0 +1,480 @@
+#include "fse.h"
+#include "blockformat.h"
+#include "histogram.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+using BlockFormat::loadUint64LE;
+using BlockFormat::storeUint64LE;
+
+// Index of the highest set bit (0 for v = 0 and 1)
+static inline int highBit(uint32_t v) {
+    int n = 0;
+    while (v >>= 1) ++n;
+    return n;
+}
+
+// --- Format constants ---
+// Block types of the FSE1 container (blockformat.h)
+enum : uint8_t { kBlockAns = 0, kBlockRaw = 1, kBlockRle = 2 };
+static constexpr int kMinTableLog = 5;
+static constexpr int kMaxTableLog = 12;
+static constexpr int kDefaultTableLog = 11;
+// Largest count header: table log, last symbol, 256 two-byte counts
+static constexpr size_t kMaxCountHeader = 2 + 2 * 256;
+
+// --- Count normalization ---
+// Scales the histogram to counts summing to 2^tableLog, every present symbol
+// keeping at least 1. Rounding leaves the sum a little off; each correction step
+// moves one unit where it costs the fewest bits over the block (count * log2 of
+// the probability change), so the result is close to the best for the table size.
+static int chooseTableLog(size_t n, int distinct) {
+    int log = kDefaultTableLog;
+    // small blocks: a table much larger than the block only costs header bytes
+    log = std::min(log, highBit((uint32_t)std::min<size_t>(n, 1u << 30)) - 1);
+    // every symbol needs a slot, plus room to tell them apart
+    log = std::max(log, highBit((uint32_t)distinct - 1) + 2);
+    return std::min(std::max(log, kMinTableLog), kMaxTableLog);
+}
+
+static void normalizeCounts(const Histogram::Counts& counts, size_t n, int tableLog, std::array<uint16_t, 256>& norm) {
+    const int64_t target = int64_t(1) << tableLog;
+    int64_t sum = 0;
+    for (int s = 0; s < 256; ++s) {
+        norm[s] = 0;
+        if (!counts[s]) continue;
+        double ideal = (double)counts[s] * (double)target / (double)n;
+        norm[s] = (uint16_t)std::max<int64_t>(1, std::llround(ideal));
+        sum += norm[s];
+    }
+    while (sum != target) {
+        int best = -1;
+        double bestCost = 0;
+        for (int s = 0; s < 256; ++s) {
+            if (!counts[s]) continue;
+            double cost;
+            if (sum > target) {
+                if (norm[s] <= 1) continue;
+                cost = (double)counts[s] * std::log2((double)norm[s] / (norm[s] - 1));
+            } else {
+                cost = -(double)counts[s] * std::log2((double)(norm[s] + 1) / norm[s]);
+            }
+            if (best < 0 || cost < bestCost) { best = s; bestCost = cost; }
+        }
+        if (sum > target) { norm[best]--; sum--; }
+        else { norm[best]++; sum++; }
+    }
+}
+
+// Count header: table log (1) | last symbol (1) | count of every symbol 0..last,
+// one byte below 128, else two (low 7 bits with the top bit set, then the rest)
+static void writeCounts(std::vector<uint8_t>& out, int tableLog, const std::array<uint16_t, 256>& norm) {
+    int last = 255;
+    while (!norm[last]) --last;
+    out.push_back((uint8_t)tableLog);
+    out.push_back((uint8_t)last);
+    for (int s = 0; s <= last; ++s) {
+        if (norm[s] < 128) {
+            out.push_back((uint8_t)norm[s]);
+        } else {
+            out.push_back((uint8_t)(0x80 | (norm[s] & 0x7F)));
+            out.push_back((uint8_t)(norm[s] >> 7));
+        }
+    }
+}
+
+static bool readCounts(const uint8_t* in, size_t size, size_t& pos, int& tableLog, std::array<uint16_t, 256>& norm) {
+    if (pos + 2 > size) return false;
+    tableLog = in[pos++];
+    int last = in[pos++];
+    if (tableLog < kMinTableLog || tableLog > kMaxTableLog) return false;
+    norm.fill(0);
+    uint32_t sum = 0;
+    int symbols = 0;
+    for (int s = 0; s <= last; ++s) {
+        if (pos >= size) return false;
+        uint32_t v = in[pos++];
+        if (v & 0x80) {
+            if (pos >= size) return false;
+            v = (v & 0x7F) | (uint32_t(in[pos++]) << 7);
+        }
+        if (v > (1u << tableLog)) return false;
+        norm[s] = (uint16_t)v;
+        sum += v;
+        symbols += v != 0;
+    }
+    // two symbols at least: a single one is stored as a run
+    return sum == (1u << tableLog) && symbols >= 2;
+}
+
+// Spreads each symbol over norm[s] slots of the state table. The odd step
+// visits every slot once and scatters a symbol's slots across the table.
+static void spreadSymbols(const std::array<uint16_t, 256>& norm, int tableLog, uint8_t* tableSymbol) {
+    const uint32_t size = 1u << tableLog;
+    const uint32_t mask = size - 1;
+    const uint32_t step = (size >> 1) + (size >> 3) + 3;
+    uint32_t position = 0;
+    for (int s = 0; s < 256; ++s) {
+        for (int i = 0; i < norm[s]; ++i) {
+            tableSymbol[position] = (uint8_t)s;
+            position = (position + step) & mask;
+        }
+    }
+}
+
+// --- Encoder ---
+// State x lives in [2^L, 2^(L+1)). Encoding s sheds the low nbBits of x so what
+// is left falls in [norm[s], 2 * norm[s]), then jumps to the slot that range maps
+// to. deltaNbBits turns "how many bits" into one add and shift; deltaFindState
+// turns the reduced state into an index of stateTable.
+struct SymbolTransform {
+    int32_t deltaFindState;
+    uint32_t deltaNbBits;
+};
+
+struct EncodeTable {
+    int tableLog;
+    std::vector<uint16_t> stateTable;
+    std::array<SymbolTransform, 256> symbolTT;
+
+    void build(const std::array<uint16_t, 256>& norm, int log) {
+        tableLog = log;
+        const uint32_t size = 1u << log;
+        std::vector<uint8_t> tableSymbol(size);
+        spreadSymbols(norm, log, tableSymbol.data());
+
+        std::array<uint32_t, 257> cumul;
+        cumul[0] = 0;
+        for (int s = 0; s < 256; ++s) cumul[s + 1] = cumul[s] + norm[s];
+        stateTable.assign(size, 0);
+        for (uint32_t u = 0; u < size; ++u) stateTable[cumul[tableSymbol[u]]++] = (uint16_t)(size + u);
+
+        uint32_t total = 0;
+        for (int s = 0; s < 256; ++s) {
+            uint32_t count = norm[s];
+            if (count == 0) {
+                symbolTT[s] = { 0, 0 };
+                continue;
+            }
+            uint32_t maxBitsOut = (uint32_t)(log - highBit(count - 1)); // count 1: all tableLog bits
+            uint32_t minStatePlus = count << maxBitsOut;
+            symbolTT[s].deltaNbBits = (maxBitsOut << 16) - minStatePlus;
+            symbolTT[s].deltaFindState = (int32_t)total - (int32_t)count;
+            total += count;
+        }
+    }
+};
+
+// LSB-first writer over a 64-bit accumulator; out needs 8 bytes of slack
+struct BitWriter {
+    uint8_t* start;
+    uint8_t* p;
+    uint64_t acc = 0;
+    int count = 0;
+    explicit BitWriter(uint8_t* out): start(out), p(out) {}
+    void add(uint64_t value, int n) {
+        acc |= (value & ((uint64_t(1) << n) - 1)) << count;
+        count += n;
+    }
+    void flush() {
+        storeUint64LE(p, acc);
+        p += count >> 3;
+        acc >>= (count & ~7);
+        count &= 7;
+    }
+    // End mark: one set bit after the data, so the reader can find where it ends
+    size_t close() {
+        add(1, 1);
+        flush();
+        return (size_t)(p - start) + (count > 0);
+    }
+};
+
+// The tables are plain pointers so the compiler keeps them in registers while
+// the writer stores bytes
+struct EncodeState {
+    uint32_t value;
+    const uint16_t* stateTable;
+    const SymbolTransform* symbolTT;
+
+    // First symbol of a state: start from the smallest state that codes it, so it costs no bits
+    EncodeState(const EncodeTable& t, uint8_t symbol): stateTable(t.stateTable.data()), symbolTT(t.symbolTT.data()) {
+        const SymbolTransform& tt = symbolTT[symbol];
+        uint32_t nbBitsOut = (tt.deltaNbBits + (1 << 15)) >> 16;
+        uint32_t v = (nbBitsOut << 16) - tt.deltaNbBits;
+        value = stateTable[(int32_t)(v >> nbBitsOut) + tt.deltaFindState];
+    }
+    void encode(BitWriter& bw, uint8_t symbol) {
+        const SymbolTransform tt = symbolTT[symbol];
+        uint32_t nbBitsOut = (value + tt.deltaNbBits) >> 16;
+        bw.add(value, (int)nbBitsOut);
+        value = stateTable[(int32_t)(value >> nbBitsOut) + tt.deltaFindState];
+    }
+};
+
+// Encodes src[0, n) (n >= 2) backwards with two alternating states; the decoder
+// gets the symbols back in forward order. Returns the bitstream size.
+static size_t encodeAns(const uint8_t* src, size_t n, const EncodeTable& t, uint8_t* out) {
+    BitWriter bw(out);
+    const uint8_t* ip = src + n;
+    // s1 codes the even positions, s2 the odd ones; each starts from the last of its own
+    EncodeState s1(t, *--ip);
+    EncodeState s2(t, *--ip);
+    if (n & 1) {
+        s1.encode(bw, *--ip);
+        bw.flush();
+    } else {
+        std::swap(s1, s2);
+    }
+    // Up to 4 symbols of <= 12 bits fit between flushes
+    size_t left = (size_t)(ip - src);
+    if (left & 2) {
+        s2.encode(bw, *--ip);
+        s1.encode(bw, *--ip);
+        bw.flush();
+    }
+    while (ip > src) {
+        s2.encode(bw, *--ip);
+        s1.encode(bw, *--ip);
+        s2.encode(bw, *--ip);
+        s1.encode(bw, *--ip);
+        bw.flush();
+    }
+    bw.add(s2.value, t.tableLog);
+    bw.add(s1.value, t.tableLog);
+    return bw.close();
+}
+
+// --- Decoder ---
+struct DecodeEntry {
+    uint16_t newState; // base of the next state, the bits read are added to it
+    uint8_t symbol;
+    uint8_t nbBits;
+};
+
+static void buildDecodeTable(const std::array<uint16_t, 256>& norm, int tableLog, DecodeEntry* table) {
+    const uint32_t size = 1u << tableLog;
+    uint8_t tableSymbol[1u << kMaxTableLog];
+    spreadSymbols(norm, tableLog, tableSymbol);
+    std::array<uint32_t, 256> next;
+    for (int s = 0; s < 256; ++s) next[s] = norm[s];
+    for (uint32_t u = 0; u < size; ++u) {
+        uint8_t s = tableSymbol[u];
+        uint32_t nextState = next[s]++;
+        int nbBits = tableLog - highBit(nextState);
+        table[u] = { (uint16_t)((nextState << nbBits) - size), s, (uint8_t)nbBits };
+    }
+}
+
+// Reads an LSB-first stream from its last bit back to its first. The container
+// holds the 8 bytes ending at ptr + 8; `consumed` counts bits taken from its top.
+class BackwardReader {
+    const uint8_t* start;
+    const uint8_t* ptr;
+    uint64_t container = 0;
+    unsigned consumed = 0;
+public:
+    enum Status { Unfinished, EndOfBuffer, Completed, Overflow };
+
+    bool init(const uint8_t* src, size_t size) {
+        if (size == 0) return false;
+        start = src;
+        uint8_t last = src[size - 1];
+        if (!last) return false; // no end mark
+        if (size >= 8) {
+            ptr = src + size - 8;
+            container = loadUint64LE(ptr);
+            consumed = 8 - highBit(last);
+        } else {
+            ptr = src;
+            for (size_t i = 0; i < size; ++i) container |= uint64_t(src[i]) << (8 * i);
+            consumed = 8 - highBit(last) + (unsigned)(8 - size) * 8;
+        }
+        return true;
+    }
+    // n may be 0; the double shift keeps every shift count below 64
+    uint32_t read(unsigned n) {
+        uint64_t v = ((container << (consumed & 63)) >> 1) >> ((63 - n) & 63);
+        consumed += n;
+        return (uint32_t)v;
+    }
+    Status reload() {
+        if (consumed > 64) return Overflow;
+        if (ptr >= start + 8) {
+            ptr -= consumed >> 3;
+            consumed &= 7;
+            container = loadUint64LE(ptr);
+            return Unfinished;
+        }
+        if (ptr == start) return consumed < 64 ? EndOfBuffer : Completed;
+        size_t bytes = consumed >> 3;
+        Status status = Unfinished;
+        if ((size_t)(ptr - start) < bytes) {
+            bytes = (size_t)(ptr - start);
+            status = EndOfBuffer;
+        }
+        ptr -= bytes;
+        consumed -= (unsigned)bytes * 8;
+        container = loadUint64LE(ptr);
+        return status;
+    }
+};
+
+// Decodes exactly n symbols (n >= 2) from the bitstream src[0, size)
+static bool decodeAns(const uint8_t* src, size_t size, const DecodeEntry* table, int tableLog, uint8_t* out, size_t n) {
+    BackwardReader br;
+    if (!br.init(src, size)) return false;
+    uint32_t s1 = br.read((unsigned)tableLog);
+    br.reload();
+    uint32_t s2 = br.read((unsigned)tableLog);
+    br.reload();
+
+    auto decode = [&](uint32_t& state) -> uint8_t {
+        const DecodeEntry e = table[state];
+        state = e.newState + br.read(e.nbBits);
+        return e.symbol;
+    };
+
+    // Hot loop: 4 symbols per reload, <= 48 bits for a table log of 12
+    size_t i = 0;
+    while (br.reload() == BackwardReader::Unfinished && i + 4 <= n) {
+        out[i] = decode(s1);
+        out[i + 1] = decode(s2);
+        out[i + 2] = decode(s1);
+        out[i + 3] = decode(s2);
+        i += 4;
+    }
+    // Tail: the stream ends when a state update runs past the first bit; the
+    // other state then holds the last symbol
+    for (;;) {
+        if (i + 2 > n) return false;
+        out[i++] = decode(s1);
+        if (br.reload() == BackwardReader::Overflow) {
+            out[i++] = table[s2].symbol;
+            break;
+        }
+        if (i + 2 > n) return false;
+        out[i++] = decode(s2);
+        if (br.reload() == BackwardReader::Overflow) {
+            out[i++] = table[s1].symbol;
+            break;
+        }
+    }
+    return i == n;
+}
+
+// --- Blocks ---
+static void encodeBlock(const uint8_t* src, size_t n, BlockFormat::EncodedBlock& block) {
+    Histogram::Counts counts = Histogram::count(src, n);
+    int distinct = 0;
+    for (uint64_t c : counts) distinct += c != 0;
+
+    block.payload.clear();
+    if (distinct == 1) {
+        block.type = kBlockRle;
+        block.payload.push_back(src[0]);
+        return;
+    }
+
+    int tableLog = chooseTableLog(n, distinct);
+    std::array<uint16_t, 256> norm;
+    normalizeCounts(counts, n, tableLog, norm);
+    EncodeTable table;
+    table.build(norm, tableLog);
+
+    // At most tableLog bits per symbol, plus the two states and the end mark
+    writeCounts(block.payload, tableLog, norm);
+    size_t header = block.payload.size();
+    block.payload.resize(header + (n * (size_t)tableLog + 2 * kMaxTableLog + 8) / 8 + 16);
+    size_t bytes = encodeAns(src, n, table, block.payload.data() + header);
+    block.payload.resize(header + bytes);
+
+    // Nothing gained: keep the bytes as they are
+    if (block.payload.size() >= n) {
+        block.type = kBlockRaw;
+        block.payload.assign(src, src + n);
+        return;
+    }
+    block.type = kBlockAns;
+}
+
+static bool decodeBlock(uint8_t type, const uint8_t* payload, size_t size, uint8_t* dst, size_t raw) {
+    switch (type) {
+    case kBlockRaw:
+        if (size != raw) return false;
+        std::memcpy(dst, payload, raw);
+        return true;
+    case kBlockRle:
+        if (size != 1) return false;
+        std::memset(dst, payload[0], raw);
+        return true;
+    case kBlockAns: {
+        if (raw < 2) return false;
+        size_t pos = 0;
+        int tableLog;
+        std::array<uint16_t, 256> norm;
+        if (!readCounts(payload, size, pos, tableLog, norm)) return false;
+        DecodeEntry table[1u << kMaxTableLog];
+        buildDecodeTable(norm, tableLog, table);
+        return decodeAns(payload + pos, size - pos, table, tableLog, dst, raw);
+    }
+    default:
+        return false;
+    }
+}
+
+// A tANS payload never outgrows the raw block (it would be stored raw); the
+// stream decoder still allows one count header on top
+static const BlockFormat::Codec kCodec = { "FSE1", kMaxCountHeader, decodeBlock };
+
+namespace Fse {
+
+bool isFse(const uint8_t* in, size_t size) {
+    return BlockFormat::hasMagic(kCodec, in, size);
+}
+
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary, const Huffman::Options& options) {
+    return BlockFormat::compressBytes(kCodec, encodeBlock, input, size, outBinary, options);
+}
+
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary, const Huffman::Options& options) {
+    return Fse::compressBytes(input.data(), input.size(), outBinary, options);
+}
+
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize) {
+    return BlockFormat::decompressedSize(kCodec, in, size, outSize);
+}
+
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads, Huffman::Progress* sink) {
+    return BlockFormat::decompressTo(kCodec, in, size, out, outSize, threads, sink);
+}
+
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads) {
+    return BlockFormat::decompressRange(kCodec, in, size, offset, length, out, threads);
+}
+
+bool verify(const uint8_t* in, size_t size, int threads, Huffman::Progress* sink) {
+    return BlockFormat::verify(kCodec, in, size, threads, sink);
+}
+
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads, Huffman::Progress* progress) {
+    return BlockFormat::decompressBytes(kCodec, in, size, outBytes, threads, progress);
+}
+
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads) {
+    return Fse::decompressBytes(inBinary.data(), inBinary.size(), outBytes, threads);
+}
+
+// --- Streaming API ---
+bool compressStream(Huffman::InputStream& in, Huffman::OutputStream& out, const Huffman::Options& options) {
+    return BlockFormat::compressStream(kCodec, encodeBlock, in, out, options);
+}
+
+bool decompressStream(Huffman::InputStream& in, Huffman::OutputStream& out, Huffman::Progress* sink) {
+    return BlockFormat::decompressStream(kCodec, in, out, sink);
+}
+
+} // namespace Fse
@@ -0,0 +1,58 @@
+#ifndef FSE_H
+#define FSE_H
+
+#include <cstdint>
+#include <vector>
+#include "huffman.h"
+
+/*
+  FSE - tANS (table-based asymmetric numeral systems) entropy coder, DSA LOGIC SUMMARY:
+  - Same byte API as Huffman (options, progress, streams are the Huffman types); unlike
+    Huffman a symbol may cost a fraction of a bit, which pays off on skewed data such as
+    text where one byte value covers half of the input
+  - Per block: histogram -> counts normalized to a power of two (2^tableLog, 5..12) ->
+    symbols spread over a 2^tableLog state table; the normalized counts are the header
+  - Encoding walks the block backwards with two interleaved states, each step one table
+    lookup and a shift (no branches); decoding reads the bitstream from its end forwards
+    in data order, one lookup + bit read per symbol
+  - Blocks with one distinct byte are stored as a run (RLE), blocks tANS cannot shrink
+    are stored raw; blocks are independent, so both directions use the worker pool
+  - Container "FSE1": block size (4) | blocks: type (1) | raw size (4) | payload size (4) |
+    [CRC-32C of the raw block (4), when type bit 7 is set] | payload ... | end 0xFF, or 0xFE +
+    file checksum (4, CRC-32C of the block CRCs) | original size (8)
+*/
+
+namespace Fse {
+
+// options.blockSize, threads and progress apply; format, maxCodeLength and
+// sharedTable are Huffman-only and ignored
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary,
+                   const Huffman::Options& options = Huffman::Options());
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary,
+                   const Huffman::Options& options = Huffman::Options());
+
+// True when the buffer starts with the FSE magic
+bool isFse(const uint8_t* in, size_t size);
+// Original size from the footer; fails when it is more than the blocks present can
+// hold, so the result is safe to allocate (runs expand far beyond Huffman's 8x)
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize);
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads = 0,
+                  Huffman::Progress* progress = nullptr);
+// Bytes [offset, offset + length) of the original, clipped at its end; only the
+// blocks covering the range are decoded (block headers are hopped over to find them)
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads = 0);
+// Decodes every block into per-worker scratch memory and checks the CRCs, keeping no output
+bool verify(const uint8_t* in, size_t size, int threads = 0, Huffman::Progress* progress = nullptr);
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads = 0,
+                     Huffman::Progress* progress = nullptr);
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads = 0);
+
+// Block by block with bounded memory; decompressStream reads and checks the magic itself
+bool compressStream(Huffman::InputStream& in, Huffman::OutputStream& out,
+                    const Huffman::Options& options = Huffman::Options());
+bool decompressStream(Huffman::InputStream& in, Huffman::OutputStream& out, Huffman::Progress* progress = nullptr);
+
+} // namespace Fse
+
+#endif // FSE_H
@@ -0,0 +1,82 @@
+#include "histogram.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int kSubTables = 8;
+// Each sub-table sees at most 1/8 of a flush window, well inside 32 bits
+constexpr size_t kFlushBytes = size_t(1) << 30;
+// Smallest slice worth a thread: below this the spawn costs more than the counting
+constexpr size_t kMinSlice = size_t(1) << 22;
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// One flush window: 16 bytes per iteration as two independent 64-bit loads, each
+// byte lane going to its own sub-table (byte order does not matter for counting)
+void countWindow(const uint8_t* p, size_t n, Histogram::Counts& counts) {
+    uint32_t sub[kSubTables][256];
+    std::memset(sub, 0, sizeof(sub));
+
+    const uint8_t* end = p + n;
+    while (end - p >= 16) {
+        uint64_t a = load64(p);
+        uint64_t b = load64(p + 8);
+        p += 16;
+        sub[0][a & 0xff]++;         sub[0][b & 0xff]++;
+        sub[1][(a >> 8) & 0xff]++;  sub[1][(b >> 8) & 0xff]++;
+        sub[2][(a >> 16) & 0xff]++; sub[2][(b >> 16) & 0xff]++;
+        sub[3][(a >> 24) & 0xff]++; sub[3][(b >> 24) & 0xff]++;
+        sub[4][(a >> 32) & 0xff]++; sub[4][(b >> 32) & 0xff]++;
+        sub[5][(a >> 40) & 0xff]++; sub[5][(b >> 40) & 0xff]++;
+        sub[6][(a >> 48) & 0xff]++; sub[6][(b >> 48) & 0xff]++;
+        sub[7][a >> 56]++;          sub[7][b >> 56]++;
+    }
+    for (int lane = 0; p < end; lane = (lane + 1) % kSubTables) sub[lane][*p++]++;
+
+    // Lane-wise fold, a straight loop the compiler vectorizes
+    for (int s = 0; s < 256; ++s) {
+        uint64_t total = 0;
+        for (int t = 0; t < kSubTables; ++t) total += sub[t][s];
+        counts[s] += total;
+    }
+}
+
+} // namespace
+
+namespace Histogram {
+
+void accumulate(const uint8_t* data, size_t size, Counts& counts) {
+    for (size_t pos = 0; pos < size; pos += kFlushBytes)
+        countWindow(data + pos, std::min(kFlushBytes, size - pos), counts);
+}
+
+Counts count(const uint8_t* data, size_t size, int threads) {
+    Counts counts{};
+    if (threads <= 0) threads = Parallel::defaultThreads();
+    size_t slices = std::min((size_t)threads, size / kMinSlice);
+    if (slices <= 1) {
+        accumulate(data, size, counts);
+        return counts;
+    }
+
+    // Equal slices, one partial table each, merged in order
+    std::vector<Counts> partial(slices, Counts{});
+    size_t sliceSize = (size + slices - 1) / slices;
+    Parallel::forEach(slices, threads, [&](size_t i) {
+        size_t begin = i * sliceSize;
+        size_t end = std::min(size, begin + sliceSize);
+        accumulate(data + begin, end - begin, partial[i]);
+    });
+    for (const Counts& p : partial)
+        for (int s = 0; s < 256; ++s) counts[s] += p[s];
+    return counts;
+}
+
+} // namespace Histogram
@@ -0,0 +1,31 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+  HISTOGRAM - byte frequency counting shared by the Huffman encoder and anything else
+  that needs symbol statistics (size estimates, charts):
+  - Bytes are read 8 at a time and spread over 8 interleaved 32-bit sub-tables, so a run
+    of one byte value updates 8 different counters instead of waiting on the same one
+    (store-to-load forwarding stalls on PDF whitespace, padded logs, ...)
+  - Sub-tables are folded into 64-bit totals every 1 GB, far before any 32-bit count fills
+  - count() with threads != 1 gives each worker a slice and merges the partial tables;
+    small inputs stay on the calling thread
+*/
+
+namespace Histogram {
+
+using Counts = std::array<uint64_t, 256>;
+
+// Adds the byte counts of data[0, size) to counts (single thread, for streaming chunks)
+void accumulate(const uint8_t* data, size_t size, Counts& counts);
+
+// Byte counts of data[0, size). threads: 1 = calling thread only, 0 = one per core
+Counts count(const uint8_t* data, size_t size, int threads = 1);
+
+} // namespace Histogram
+
+#endif // HISTOGRAM_H
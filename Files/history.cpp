@@ -706,7 +706,27 @@ void HistoryWindow::onFilterChanged(int index)
 
 void HistoryWindow::addCompressionRecord(const QString &fileType, qint64 originalSize, qint64 compressedSize, const QString &filePath)
 {
-    if (originalSize <= 0) return;
+    if (!appendCompressionRecord(fileType, originalSize, compressedSize, filePath)) return;
+    trimHistory();
+    saveHistory();
+    refreshHistoryTable();
+}
+
+void HistoryWindow::addCompressionRecords(const QVector<BatchRecord> &records)
+{
+    bool added = false;
+    for (const BatchRecord &record : records) {
+        added |= appendCompressionRecord(record.fileType, record.originalSize, record.compressedSize, record.filePath);
+    }
+    if (!added) return;
+    trimHistory();
+    saveHistory();
+    refreshHistoryTable();
+}
+
+bool HistoryWindow::appendCompressionRecord(const QString &fileType, qint64 originalSize, qint64 compressedSize, const QString &filePath)
+{
+    if (originalSize <= 0) return false;
     
     HistoryRecord record;
     record.type = "Compress";
@@ -719,14 +739,15 @@ void HistoryWindow::addCompressionRecord(const QString &fileType, qint64 origina
     record.compressionRatio = 100.0 * (1.0 - (double)compressedSize / originalSize);
     
     historyRecords.append(record);
-    
+    return true;
+}
+
+void HistoryWindow::trimHistory()
+{
     // Keep only last 500 records
     if (historyRecords.size() > 500) {
         historyRecords = historyRecords.mid(historyRecords.size() - 500);
     }
-    
-    saveHistory();
-    refreshHistoryTable();
 }
 
 void HistoryWindow::addDecompressionRecord(const QString &fileType, qint64 compressedSize, qint64 decompressedSize, const QString &filePath)
@@ -14,6 +14,8 @@
 #include <QTime>
 #include <QResizeEvent>
 #include <QComboBox>
+#include <QVector>
+#include "compressionjob.h"
 
 class HistoryWindow : public QWidget
 {
@@ -26,6 +28,8 @@ public:
     // Public methods to add records
     void addCompressionRecord(const QString &fileType, qint64 originalSize, qint64 compressedSize, const QString &filePath = "");
     void addDecompressionRecord(const QString &fileType, qint64 compressedSize, qint64 decompressedSize, const QString &filePath = "");
+    // Batch version: appends every record, then saves and refreshes the table once
+    void addCompressionRecords(const QVector<BatchRecord> &records);
 
 signals:
     void navigateToDashboard();
@@ -50,6 +54,8 @@ private:
     void updateResponsiveSizes();
     void loadHistory();
     void saveHistory();
+    bool appendCompressionRecord(const QString &fileType, qint64 originalSize, qint64 compressedSize, const QString &filePath);
+    void trimHistory();
     void refreshHistoryTable();
     void clearHistory();
     void onFilterChanged(int index);
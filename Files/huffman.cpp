@@ -1,223 +1,1820 @@
 #include "huffman.h"
-#include <queue>
-#include <memory>
 #include <cstring>
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+#include "blockformat.h"
+#include "checksum.h"
+#include "histogram.h"
+#include "parallel.h"
 
-// --- Helpers for binary read/write in memory ---
-static void writeUint32(std::vector<uint8_t>& out, uint32_t v) {
-    for (int i = 0; i < 4; ++i) out.push_back((v >> (i*8)) & 0xFF);
+using BlockFormat::readUint32;
+using BlockFormat::readUint64;
+using BlockFormat::writeUint32;
+using BlockFormat::writeUint64;
+using BlockFormat::loadUint64LE;
+using BlockFormat::storeUint64LE;
+using BlockFormat::kMinBlockSize;
+using BlockFormat::kMaxBlockSize;
+using BlockFormat::kBlockHeaderSize;
+using BlockFormat::kChecksumSize;
+using BlockFormat::clampBlockSize;
+using BlockFormat::chainCrc;
+using BlockFormat::ProgressTracker;
+using BlockFormat::readFully;
+
+// --- DSA: Huffman tree in a flat array ---
+// Leaves first, then internal nodes in the order they are merged, so every
+// parent sits after its children and the root is the last entry: at most
+// 256 leaves + 255 merges = 511 nodes, no allocation and no pointers.
+static constexpr int kMaxTreeNodes = 511;
+
+struct HuffTree {
+    uint64_t freq[kMaxTreeNodes];
+    uint16_t child[kMaxTreeNodes][2]; // internal nodes: left (bit 0), right (bit 1)
+    uint8_t symbol[kMaxTreeNodes];    // leaves
+    int leaves = 0;
+    int count = 0;
+
+    int root() const { return count - 1; }
+    bool isLeaf(int n) const { return n < leaves; }
+    int addLeaf(uint8_t sym, uint64_t f) {
+        symbol[count] = sym;
+        freq[count] = f;
+        leaves++;
+        return count++;
+    }
+    int merge(int a, int b) {
+        child[count][0] = (uint16_t)a;
+        child[count][1] = (uint16_t)b;
+        freq[count] = freq[a] + freq[b];
+        return count++;
+    }
+    // Depth of every node, top-down (a parent is always after its children)
+    void depths(uint8_t* depth) const {
+        depth[root()] = 0;
+        for (int n = root(); n >= leaves; --n)
+            depth[child[n][0]] = depth[child[n][1]] = (uint8_t)std::min(depth[n] + 1, 255);
+    }
+};
+
+// Two-queue construction, O(m) after sorting the leaves: leaves wait in one
+// queue by ascending frequency, merged nodes come out in ascending order too,
+// so the two smallest are always at the queue fronts. Ties go to the leaf,
+// which keeps the longest code as short as possible.
+static bool buildTree(const std::array<uint64_t, 256>& freq, HuffTree& t) {
+    for (int i = 0; i < 256; ++i) if (freq[i]) t.addLeaf((uint8_t)i, freq[i]);
+    if (t.leaves == 0) return false;
+    // A single symbol still needs a sibling to get a 1-bit code
+    if (t.leaves == 1) t.addLeaf(0, 0);
+
+    uint16_t order[256];
+    for (int i = 0; i < t.leaves; ++i) order[i] = (uint16_t)i;
+    std::sort(order, order + t.leaves, [&](uint16_t a, uint16_t b) { return t.freq[a] < t.freq[b]; });
+
+    int leafHead = 0, nodeHead = t.leaves;
+    auto smallest = [&]() -> int {
+        if (leafHead < t.leaves && (nodeHead == t.count || t.freq[order[leafHead]] <= t.freq[nodeHead]))
+            return order[leafHead++];
+        return nodeHead++;
+    };
+    while (t.count < 2 * t.leaves - 1) {
+        int a = smallest();
+        int b = smallest();
+        t.merge(a, b);
+    }
+    return true;
 }
-static uint32_t readUint32(const std::vector<uint8_t>& in, size_t& pos) {
-    uint32_t v = 0;
-    for (int i = 0; i < 4; ++i) v |= uint32_t(in[pos++]) << (i*8);
-    return v;
+
+// HUF1 stores frequencies, not codes, so its tree must come out exactly as the
+// original encoder's std::priority_queue built it. Same leaf insertion order,
+// same push_heap/pop_heap calls and comparison (which is all priority_queue
+// does), only on node indices instead of shared_ptr.
+static bool buildLegacyTree(const std::array<uint64_t, 256>& freq, HuffTree& t) {
+    uint16_t heap[256];
+    int size = 0;
+    auto cmp = [&](uint16_t a, uint16_t b) { return t.freq[a] > t.freq[b]; }; // min-heap
+    auto push = [&](int n) { heap[size++] = (uint16_t)n; std::push_heap(heap, heap + size, cmp); };
+    auto pop = [&]() -> int { std::pop_heap(heap, heap + size, cmp); return heap[--size]; };
+
+    for (int i = 0; i < 256; ++i) if (freq[i]) push(t.addLeaf((uint8_t)i, freq[i]));
+    if (size == 0) return false;
+    // Edge: if only one distinct symbol, pair it with a dummy sibling
+    if (size == 1) {
+        int only = pop();
+        push(t.merge(only, t.addLeaf(0, 0)));
+    }
+
+    // Build Huffman tree (DSA: min-heap merging) O(m log m)
+    while (size > 1) {
+        int a = pop();
+        int b = pop();
+        push(t.merge(a, b));
+    }
+    return true;
 }
-static void writeUint64(std::vector<uint8_t>& out, uint64_t v) {
-    for (int i = 0; i < 8; ++i) out.push_back((v >> (i*8)) & 0xFF);
+
+// HUF1 codes (DSA: root-to-leaf paths). Each code is kept as an integer whose
+// bit 0 is the first bit sent (left = 0, right = 1) plus its length. Like the
+// original DFS, a later leaf overwrites an earlier one with the same byte,
+// which only matters for the dummy of a single-symbol tree.
+static void buildCodes(const HuffTree& t, std::array<uint64_t, 256>& bits, std::array<uint8_t, 256>& lens, int& maxLen) {
+    uint8_t depth[kMaxTreeNodes];
+    uint64_t code[kMaxTreeNodes];
+    t.depths(depth);
+    code[t.root()] = 0;
+    for (int n = t.root(); n >= t.leaves; --n) {
+        code[t.child[n][0]] = code[n];
+        // deeper than a 64-bit code can hold: maxLen rules the tree out below
+        code[t.child[n][1]] = depth[n] < 64 ? code[n] | (1ull << depth[n]) : code[n];
+    }
+    for (int n = 0; n < t.leaves; ++n) {
+        bits[t.symbol[n]] = code[n];
+        lens[t.symbol[n]] = std::max(depth[n], (uint8_t)1);
+        maxLen = std::max(maxLen, (int)depth[n]);
+    }
 }
-static uint64_t readUint64(const std::vector<uint8_t>& in, size_t& pos) {
-    uint64_t v = 0;
-    for (int i = 0; i < 8; ++i) v |= uint64_t(in[pos++]) << (i*8);
-    return v;
+
+// Code lengths of the real symbols; the zero-frequency dummy of a
+// single-symbol tree is skipped.
+static void buildLengths(const HuffTree& t, std::array<uint8_t, 256>& lengths, int& maxLen) {
+    uint8_t depth[kMaxTreeNodes];
+    t.depths(depth);
+    for (int n = 0; n < t.leaves; ++n) {
+        if (!t.freq[n]) continue;
+        lengths[t.symbol[n]] = depth[n];
+        maxLen = std::max(maxLen, (int)depth[n]);
+    }
+}
+
+// --- Length-limited codes: package-merge (Larmore & Hirschberg) ---
+// Optimal lengths under the constraint that none exceeds maxLen. Level 0 holds
+// the leaves sorted by frequency (denomination 2^-maxLen); every level above
+// merges the leaves with packages of adjacent pairs from the level below. The
+// first 2m-2 items of the top level are selected, and each selected leaf adds
+// one bit to its symbol's length. Only a leaf/package flag per item is kept,
+// since the selected items of a level are always a prefix: the first a leaves
+// plus packages covering the first 2p items of the level below.
+static void limitedLengths(const std::array<uint64_t, 256>& freq, int maxLen, std::array<uint8_t, 256>& lengths) {
+    std::array<uint8_t, 256> syms;
+    int m = 0;
+    for (int i = 0; i < 256; ++i) if (freq[i]) syms[m++] = (uint8_t)i;
+    lengths.fill(0);
+    if (m == 1) { lengths[syms[0]] = 1; return; }
+    std::stable_sort(syms.begin(), syms.begin() + m, [&](uint8_t a, uint8_t b) { return freq[a] < freq[b]; });
+
+    // 2^maxLen slots must hold m leaves
+    while ((1ull << std::min(maxLen, 63)) < (uint64_t)m) ++maxLen;
+
+    std::vector<uint64_t> prev, cur;
+    std::vector<std::vector<uint8_t>> isLeaf(maxLen);
+    for (int i = 0; i < m; ++i) prev.push_back(freq[syms[i]]);
+    isLeaf[0].assign(m, 1);
+    for (int level = 1; level < maxLen; ++level) {
+        cur.clear();
+        size_t packages = prev.size() / 2;
+        size_t li = 0, pi = 0;
+        while (li < (size_t)m || pi < packages) {
+            uint64_t pw = pi < packages ? prev[2 * pi] + prev[2 * pi + 1] : 0;
+            if (pi >= packages || (li < (size_t)m && freq[syms[li]] <= pw)) {
+                cur.push_back(freq[syms[li++]]);
+                isLeaf[level].push_back(1);
+            } else {
+                cur.push_back(pw);
+                isLeaf[level].push_back(0);
+                pi++;
+            }
+        }
+        prev.swap(cur);
+    }
+
+    size_t take = 2 * (size_t)m - 2;
+    for (int level = maxLen - 1; level >= 0 && take; --level) {
+        size_t leaves = 0;
+        for (size_t i = 0; i < take; ++i) leaves += isLeaf[level][i];
+        for (size_t i = 0; i < leaves; ++i) lengths[syms[i]]++;
+        take = 2 * (take - leaves);
+    }
 }
 
-// --- DSA: Huffman tree structures ---
-struct Node {
-    uint8_t byteVal;
-    uint64_t freq;
-    std::shared_ptr<Node> left, right;
-    Node(uint8_t b, uint64_t f): byteVal(b), freq(f), left(nullptr), right(nullptr) {}
-    Node(std::shared_ptr<Node> l, std::shared_ptr<Node> r): byteVal(0), freq(l->freq + r->freq), left(l), right(r) {}
+// --- Canonical codes (HUF2) ---
+// Only the code lengths are stored; codes are reassigned in DEFLATE order
+// (shorter codes first, ties by symbol value). A code must fit in 64 bits,
+// which any input smaller than ~27 TB satisfies.
+static constexpr int kMaxCodeLength = 64;
+
+// Fills codes[] (MSB = first bit sent) from lengths[]. Returns false if the
+// lengths do not describe a complete prefix code. A lone symbol of length 1
+// is the one accepted incomplete code.
+static bool canonicalCodes(const std::array<uint8_t, 256>& lengths, std::array<uint64_t, 256>& codes) {
+    std::array<uint32_t, kMaxCodeLength + 1> lenCount{};
+    int symbols = 0;
+    for (int i = 0; i < 256; ++i) {
+        if (lengths[i] > kMaxCodeLength) return false;
+        if (lengths[i]) { lenCount[lengths[i]]++; symbols++; }
+    }
+    if (symbols == 0) return false;
+    if (symbols == 1) {
+        for (int i = 0; i < 256; ++i) if (lengths[i]) { if (lengths[i] != 1) return false; codes[i] = 0; }
+        return true;
+    }
+
+    // Kraft check: count the unused code space level by level
+    uint64_t left = 1;
+    std::array<uint64_t, kMaxCodeLength + 1> nextCode{};
+    uint64_t code = 0;
+    for (int len = 1; len <= kMaxCodeLength; ++len) {
+        left = (left << 1) - lenCount[len];
+        if ((int64_t)left < 0) return false;   // over-subscribed
+        if (left > 256) return false;          // more free slots than symbols can ever fill
+        code = (code + lenCount[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+    if (left != 0) return false;
+
+    for (int i = 0; i < 256; ++i) if (lengths[i]) codes[i] = nextCode[lengths[i]]++;
+    return true;
+}
+
+static inline uint64_t reverseBits(uint64_t code, int len) {
+    uint64_t r = 0;
+    for (int i = 0; i < len; ++i) r |= ((code >> i) & 1) << (len - 1 - i);
+    return r;
+}
+
+// --- Progress reporting ---
+// Long loops work in slices of kProgressStep bytes and report after each one
+static constexpr size_t kProgressStep = 4 << 20;
+
+// Bits not yet stored by encodeSymbols, carried from one chunk to the next
+struct BitState {
+    uint64_t acc = 0;
+    int count = 0;
 };
 
-struct Cmp {
-    bool operator()(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b) const {
-        return a->freq > b->freq; // min-heap
+// 64-bit accumulator encoder. Codes are appended LSB-first; after every group
+// of symbols the accumulator is stored as a whole word and advanced by the
+// complete bytes it held, leaving at most 7 bits behind. Up to 56 bits can
+// therefore be added per flush: four codes of <= 14 bits or two of <= 28.
+// out needs room for the exact output plus 8 bytes of slack for the word
+// stores. Returns the number of complete bytes written; the 0..7 leftover bits
+// stay in the state so a long input can be encoded chunk by chunk.
+static size_t encodeSymbols(const uint8_t* in, size_t n, const uint64_t* bits, const uint8_t* lens,
+                            int maxLen, uint8_t* out, BitState& state) {
+    uint8_t* p = out;
+    uint64_t acc = state.acc;
+    int count = state.count;
+    auto flush = [&]() {
+        storeUint64LE(p, acc);
+        p += count >> 3;
+        acc >>= (count & ~7);
+        count &= 7;
+    };
+
+    size_t i = 0;
+    if (maxLen <= 28) {
+        // one table load per symbol: code in the low 56 bits, length on top
+        uint64_t packed[256];
+        for (int s = 0; s < 256; ++s) packed[s] = bits[s] | (uint64_t)lens[s] << 56;
+        auto put = [&](uint8_t b) {
+            uint64_t e = packed[b];
+            acc |= (e & 0x00FFFFFFFFFFFFFFull) << count;
+            count += (int)(e >> 56);
+        };
+        if (maxLen <= 14) {
+            for (; i + 4 <= n; i += 4) {
+                put(in[i]); put(in[i + 1]); put(in[i + 2]); put(in[i + 3]);
+                flush();
+            }
+        } else {
+            for (; i + 2 <= n; i += 2) {
+                put(in[i]); put(in[i + 1]);
+                flush();
+            }
+        }
+    }
+    for (; i < n; ++i) {
+        uint8_t b = in[i];
+        if (lens[b] <= 56) {
+            acc |= bits[b] << count; count += lens[b];
+        } else {
+            acc |= (bits[b] & 0xFFFFFFFFu) << count; count += 32;
+            flush();
+            acc |= (bits[b] >> 32) << count; count += lens[b] - 32;
+        }
+        flush();
     }
+    state.acc = acc;
+    state.count = count;
+    return (size_t)(p - out);
+}
+
+// --- Table-driven decoder ---
+// The decoder keeps its own copy of the tree with the root at index 0, so a
+// child index of 0 can mark a leaf. A 2^kTableBits lookup table resolves up to two symbols per
+// peek of the bit buffer; codes longer than the table fall back to walking
+// the flat tree one bit at a time from the node the table stopped at.
+static constexpr int kTableBits = 11;
+static constexpr uint32_t kTableSize = 1u << kTableBits;
+static constexpr uint32_t kTableMask = kTableSize - 1;
+// Interleaved blocks: sub-streams per block and the size of their jump table
+static constexpr int kStreams = 4;
+static constexpr size_t kJumpTableSize = 4 * (kStreams - 1);
+
+struct FlatTree {
+    uint16_t child[511][2]; // child[n][0] == 0 marks a leaf (root is never a child)
+    uint8_t symbol[511];
+    int count = 0;
+};
+
+struct TableEntry {
+    uint16_t symbols; // sym0 | sym1 << 8, or the flat tree node for long codes
+    uint8_t bits;     // bits consumed by this entry
+    uint8_t count;    // symbols produced: 1 or 2, 0 = code longer than the table
 };
 
-// Generate codes by DFS (DSA logic)
-static void buildCodes(const std::shared_ptr<Node>& node, std::string& cur, std::array<std::string, 256>& codes) {
-    if (!node) return;
-    if (!node->left && !node->right) {
-        // leaf
-        codes[node->byteVal] = cur.empty() ? "0" : cur; // single-symbol file => code "0"
+// Copies a built tree in pre-order, which puts the root at index 0
+static int flattenTree(const HuffTree& h, int node, FlatTree& t) {
+    int idx = t.count++;
+    t.symbol[idx] = h.isLeaf(node) ? h.symbol[node] : 0;
+    t.child[idx][0] = t.child[idx][1] = 0;
+    if (!h.isLeaf(node)) {
+        int l = flattenTree(h, h.child[node][0], t);
+        int r = flattenTree(h, h.child[node][1], t);
+        t.child[idx][0] = (uint16_t)l;
+        t.child[idx][1] = (uint16_t)r;
+    }
+    return idx;
+}
+
+// Builds the decoding tree from canonical codes. A lone symbol gets a phantom
+// sibling decoding to itself, so every internal node has two children.
+static void treeFromCodes(const std::array<uint8_t, 256>& lengths, const std::array<uint64_t, 256>& codes, FlatTree& t) {
+    t.count = 1;
+    t.child[0][0] = t.child[0][1] = 0;
+    t.symbol[0] = 0;
+    int last = 0;
+    for (int sym = 0; sym < 256; ++sym) {
+        if (!lengths[sym]) continue;
+        int node = 0;
+        for (int i = lengths[sym] - 1; i >= 0; --i) {
+            int b = (codes[sym] >> i) & 1;
+            if (t.child[node][b] == 0) {
+                int n = t.count++;
+                t.child[n][0] = t.child[n][1] = 0;
+                t.symbol[n] = 0;
+                t.child[node][b] = (uint16_t)n;
+            }
+            node = t.child[node][b];
+        }
+        t.symbol[node] = (uint8_t)sym;
+        last = sym;
+    }
+    if (t.child[0][1] == 0) {
+        int n = t.count++;
+        t.child[n][0] = t.child[n][1] = 0;
+        t.symbol[n] = (uint8_t)last;
+        t.child[0][1] = (uint16_t)n;
+    }
+}
+
+// Bits are packed LSB-first, so the first bit of a code is bit 0 of the index.
+static void fillTable(const FlatTree& t, int node, uint32_t prefix, int depth, TableEntry* table) {
+    if (t.child[node][0] == 0) {
+        for (uint32_t i = prefix; i < kTableSize; i += (1u << depth))
+            table[i] = { t.symbol[node], (uint8_t)depth, 1 };
+        return;
+    }
+    if (depth == kTableBits) {
+        table[prefix] = { (uint16_t)node, (uint8_t)kTableBits, 0 };
         return;
     }
-    cur.push_back('0');
-    buildCodes(node->left, cur, codes);
-    cur.pop_back();
-    cur.push_back('1');
-    buildCodes(node->right, cur, codes);
-    cur.pop_back();
+    fillTable(t, t.child[node][0], prefix, depth + 1, table);
+    fillTable(t, t.child[node][1], prefix | (1u << depth), depth + 1, table);
+}
+
+// Second pass: pair each short code with the code that follows it whenever
+// both fit inside the peeked kTableBits.
+static void pairTableEntries(TableEntry* table) {
+    TableEntry single[kTableSize];
+    std::memcpy(single, table, sizeof(single));
+    for (uint32_t i = 0; i < kTableSize; ++i) {
+        const TableEntry& a = single[i];
+        if (a.count != 1 || a.bits >= kTableBits) continue;
+        const TableEntry& b = single[i >> a.bits];
+        if (b.count == 1 && a.bits + b.bits <= kTableBits)
+            table[i] = { (uint16_t)(a.symbols | (b.symbols << 8)), (uint8_t)(a.bits + b.bits), 2 };
+    }
 }
 
-// pack bits to bytes
-class BitWriter {
-    uint8_t cur = 0;
-    int used = 0;
-    std::vector<uint8_t>& out;
+// 64-bit LSB-first bit buffer. Past the end of the input it shifts in zero
+// bytes and remembers how many, so the caller can tell whether any of those
+// phantom bits were actually consumed. The bit state can be carried over to a
+// new buffer when input arrives in chunks.
+class BitBuffer {
+    const uint8_t* in;
+    size_t size;
+    size_t pos;
+    uint64_t padBits = 0;
 public:
-    BitWriter(std::vector<uint8_t>& o): out(o) {}
-    void writeBit(int b) {
-        if (b) cur |= (1 << used);
-        used++;
-        if (used == 8) {
-            out.push_back(cur);
-            cur = 0; used = 0;
+    uint64_t buf;
+    int count;
+    BitBuffer(const uint8_t* data, size_t n, size_t startPos, uint64_t bits = 0, int bitCount = 0)
+        : in(data), size(n), pos(startPos), buf(bits), count(bitCount) {}
+    // Tops the buffer up to at least 56 bits.
+    void refill() {
+        if (pos + 8 <= size) {
+            buf |= loadUint64LE(in + pos) << count;
+            pos += (63 - count) >> 3;
+            count |= 56;
+            return;
+        }
+        while (count <= 56) {
+            if (pos < size) buf |= uint64_t(in[pos++]) << count;
+            else padBits += 8;
+            count += 8;
         }
     }
-    void writeBitsFromString(const std::string& s) {
-        for (char c : s) writeBit(c == '1');
+    void consume(int n) { buf >>= n; count -= n; }
+    bool overrun() const { return (uint64_t)count < padBits; }
+    size_t position() const { return pos; }
+    // Bits consumed since the start of data
+    uint64_t bitPosition() const { return (uint64_t)pos * 8 + padBits - count; }
+};
+
+// One loop iteration reads at most 24 bytes ahead (a refill plus a 64-bit
+// long code); chunked callers stop this far before the end of real data.
+static constexpr size_t kChunkSlack = 32;
+
+// Decodes up to outSize symbols into out and returns how many were written.
+// Decoding also stops once the reader passes stopPos (chunked input) or runs
+// into the zero padding past the end (corrupt or truncated input).
+static size_t decodeSymbols(const FlatTree& t, const TableEntry* table, BitBuffer& br,
+                            uint8_t* out, size_t outSize, size_t stopPos = SIZE_MAX) {
+    size_t n = 0;
+    // Hot loop: 56+ buffered bits cover four lookups of up to kTableBits each,
+    // and each lookup writes two bytes (the second only counts if paired).
+    while (outSize - n >= 8 && br.position() < stopPos) {
+        br.refill();
+        for (int k = 0; k < 4; ++k) {
+            const TableEntry e = table[br.buf & kTableMask];
+            if (e.count == 0) {
+                // long code: continue from the node the table stopped at
+                int node = e.symbols;
+                br.consume(kTableBits);
+                while (t.child[node][0] != 0) {
+                    if (br.count == 0) br.refill();
+                    node = t.child[node][br.buf & 1];
+                    br.consume(1);
+                }
+                out[n++] = t.symbol[node];
+                break;
+            }
+            out[n] = (uint8_t)e.symbols;
+            out[n + 1] = (uint8_t)(e.symbols >> 8);
+            n += e.count;
+            br.consume(e.bits);
+        }
+        if (br.overrun()) return n;
     }
-    void flush() {
-        if (used) {
-            out.push_back(cur);
-            cur = 0; used = 0;
+    // Tail: fewer than 8 symbols left, walk the tree so a paired entry can
+    // never run past outSize.
+    while (n < outSize && br.position() < stopPos) {
+        int node = 0;
+        while (t.child[node][0] != 0) {
+            if (br.count == 0) br.refill();
+            node = t.child[node][br.buf & 1];
+            br.consume(1);
         }
+        out[n++] = t.symbol[node];
     }
+    return n;
+}
+
+// --- Canonical code sets (HUF2 and HUFB blocks) ---
+struct CodeSet {
+    std::array<uint64_t, 256> bits{};   // LSB-first, ready for encodeSymbols
+    std::array<uint8_t, 256> lengths{};
+    int maxLen = 0;
 };
 
-// read bits
-class BitReader {
-    const std::vector<uint8_t>& in;
-    size_t pos;
-    uint8_t cur;
-    int used;
-public:
-    BitReader(const std::vector<uint8_t>& data, size_t startPos): in(data), pos(startPos), cur(0), used(8) {}
-    // returns -1 on EOF
-    int readBit() {
-        if (used == 8) {
-            if (pos >= in.size()) return -1;
-            cur = in[pos++];
-            used = 0;
+static bool buildCanonicalCodes(const std::array<uint64_t, 256>& freq, int maxCodeLength, CodeSet& cs) {
+    HuffTree tree;
+    if (!buildTree(freq, tree)) return false;
+    buildLengths(tree, cs.lengths, cs.maxLen);
+    // Recompute under a cap when the plain tree runs too deep (lengths
+    // past kMaxCodeLength only occur for inputs far beyond memory)
+    int limit = maxCodeLength > 0 ? std::min(maxCodeLength, kMaxCodeLength) : kMaxCodeLength;
+    if (cs.maxLen > limit) {
+        limitedLengths(freq, limit, cs.lengths);
+        cs.maxLen = *std::max_element(cs.lengths.begin(), cs.lengths.end());
+    }
+    std::array<uint64_t, 256> canon{};
+    if (!canonicalCodes(cs.lengths, canon)) return false;
+    // canonical codes are MSB-first; the stream is LSB-first
+    for (int i = 0; i < 256; ++i) cs.bits[i] = reverseBits(canon[i], cs.lengths[i]);
+    return true;
+}
+
+// Code length table: last used symbol (1 byte), max code length (1 byte), then
+// one length per symbol 0..last, packed two per byte (low nibble first) when
+// the max length is <= 15, else one byte each
+static size_t lengthsBytes(const CodeSet& cs) {
+    int last = 255;
+    while (!cs.lengths[last]) --last;
+    return 2 + (cs.maxLen <= 15 ? last / 2 + 1 : last + 1);
+}
+
+static void writeLengths(std::vector<uint8_t>& out, const CodeSet& cs) {
+    int last = 255;
+    while (!cs.lengths[last]) --last;
+    out.push_back((uint8_t)last);
+    out.push_back((uint8_t)cs.maxLen);
+    if (cs.maxLen <= 15) {
+        for (int i = 0; i <= last; i += 2)
+            out.push_back((uint8_t)(cs.lengths[i] | ((i + 1 <= last ? cs.lengths[i + 1] : 0) << 4)));
+    } else {
+        for (int i = 0; i <= last; ++i) out.push_back(cs.lengths[i]);
+    }
+}
+
+static bool readLengths(const uint8_t* in, size_t size, size_t& pos, std::array<uint8_t, 256>& lengths) {
+    if (pos + 2 > size) return false;
+    int last = in[pos++];
+    int maxLen = in[pos++];
+    lengths.fill(0);
+    if (maxLen <= 15) {
+        if (pos + (size_t)(last / 2 + 1) > size) return false;
+        for (int i = 0; i <= last; i += 2) {
+            uint8_t packed = in[pos++];
+            lengths[i] = packed & 0x0F;
+            if (i + 1 <= last) lengths[i + 1] = packed >> 4;
         }
-        int b = (cur >> used) & 1;
-        used++;
-        return b;
+    } else {
+        if (pos + (size_t)(last + 1) > size) return false;
+        for (int i = 0; i <= last; ++i) lengths[i] = in[pos++];
+    }
+    return true;
+}
+
+// Appends the bitstream for data[0..n). The exact size is known from the
+// histogram, so the output is sized once and the encoder writes straight into it.
+static size_t streamBytesOf(const std::array<uint64_t, 256>& freq, const std::array<uint8_t, 256>& lengths) {
+    uint64_t totalBits = 0;
+    for (int i = 0; i < 256; ++i) totalBits += freq[i] * lengths[i];
+    return (size_t)((totalBits + 7) / 8);
+}
+
+static bool appendStream(const uint8_t* data, size_t n, const std::array<uint64_t, 256>& freq,
+                         const std::array<uint64_t, 256>& bits, const std::array<uint8_t, 256>& lengths,
+                         int maxLen, std::vector<uint8_t>& out, ProgressTracker* progress = nullptr) {
+    size_t header = out.size();
+    size_t streamBytes = streamBytesOf(freq, lengths);
+    out.resize(header + streamBytes + 8);
+    BitState state;
+    size_t written = 0;
+    for (size_t i = 0; i < n; i += kProgressStep) {
+        size_t len = std::min(kProgressStep, n - i);
+        written += encodeSymbols(data + i, len, bits.data(), lengths.data(), maxLen,
+                                 out.data() + header + written, state);
+        if (progress && !progress->advance(len)) return false;
+    }
+    if (state.count) out[header + written++] = (uint8_t)state.acc;
+    out.resize(header + written);
+    return written == streamBytes;
+}
+
+// Interleaved layout (Huff0 style): the input is cut into 4 contiguous quarters,
+// each coded as its own bitstream with the same codes, preceded by a jump table
+// holding the byte sizes of streams 0..2 (the last one runs to the payload end).
+// quarterFreq[s] is the histogram of quarter s.
+static bool appendInterleaved(const uint8_t* data, size_t n, const std::array<uint64_t, 256>* quarterFreq,
+                              const CodeSet& cs, std::vector<uint8_t>& out) {
+    size_t jump = out.size();
+    out.resize(jump + kJumpTableSize);
+    size_t quarter = (n + kStreams - 1) / kStreams;
+    for (int s = 0; s < kStreams; ++s) {
+        size_t begin = std::min(n, s * quarter);
+        size_t len = std::min(n, begin + quarter) - begin;
+        size_t streamStart = out.size();
+        if (!appendStream(data + begin, len, quarterFreq[s], cs.bits, cs.lengths, cs.maxLen, out)) return false;
+        if (s < kStreams - 1) {
+            uint32_t bytes = (uint32_t)(out.size() - streamStart);
+            for (int b = 0; b < 4; ++b) out[jump + 4 * s + b] = (uint8_t)(bytes >> (8 * b));
+        }
+    }
+    return true;
+}
+
+// Lookup table + flat tree for one code, built once and shared read-only by
+// any number of threads.
+struct Decoder {
+    FlatTree tree;
+    std::array<TableEntry, kTableSize> table;
+    int maxLen = 0; // canonical codes only
+
+    void buildTable() {
+        fillTable(tree, 0, 0, 0, table.data());
+        pairTableEntries(table.data());
+    }
+    // Codes come from the lengths alone: no frequencies, no tree construction
+    bool initCanonical(const std::array<uint8_t, 256>& lengths) {
+        std::array<uint64_t, 256> codes{};
+        if (!canonicalCodes(lengths, codes)) return false;
+        treeFromCodes(lengths, codes, tree);
+        buildTable();
+        maxLen = *std::max_element(lengths.begin(), lengths.end());
+        return true;
+    }
+    bool decode(const uint8_t* data, size_t size, size_t pos, uint8_t* out, uint64_t n,
+                ProgressTracker* progress = nullptr) const {
+        // A valid stream spends at least one bit per symbol
+        if (pos > size || n > (uint64_t)(size - pos) * 8) return false;
+        BitBuffer br(data, size, pos);
+        if (!progress)
+            return decodeSymbols(tree, table.data(), br, out, (size_t)n) == n && !br.overrun();
+        for (size_t i = 0; i < n; i += kProgressStep) {
+            size_t len = std::min(kProgressStep, (size_t)n - i);
+            if (decodeSymbols(tree, table.data(), br, out + i, len) != len || br.overrun() ||
+                !progress->advance(len)) return false;
+        }
+        return true;
+    }
+    // Four sub-streams behind a jump table (see appendInterleaved). Needs codes
+    // of at most kTableBits, so every lookup yields one or two whole symbols.
+    bool decode4(const uint8_t* data, size_t size, size_t pos, uint8_t* out, uint64_t n) const {
+        if (maxLen > kTableBits || pos > size || size - pos < kJumpTableSize) return false;
+        size_t start[kStreams + 1];
+        start[0] = pos + kJumpTableSize;
+        for (int s = 0; s < kStreams - 1; ++s) {
+            start[s + 1] = start[s] + readUint32(data, pos);
+            if (start[s + 1] > size) return false;
+        }
+        start[kStreams] = size;
+
+        BitBuffer br[kStreams] = {
+            BitBuffer(data, start[1], start[0]), BitBuffer(data, start[2], start[1]),
+            BitBuffer(data, start[3], start[2]), BitBuffer(data, start[4], start[3]),
+        };
+        uint8_t* dst[kStreams];
+        size_t left[kStreams];
+        size_t quarter = (size_t)(n + kStreams - 1) / kStreams;
+        for (int s = 0; s < kStreams; ++s) {
+            size_t begin = std::min((size_t)n, s * quarter);
+            dst[s] = out + begin;
+            left[s] = std::min((size_t)n, begin + quarter) - begin;
+            // a valid stream spends at least one bit per symbol
+            if (left[s] > (uint64_t)(start[s + 1] - start[s]) * 8) return false;
+        }
+
+        // Hot loop: the four readers have no data dependency on each other, so
+        // their refills and lookups overlap. Each stream takes four lookups of
+        // up to kTableBits from its 56+ buffered bits and writes at most 8 bytes.
+        const TableEntry* t = table.data();
+        while (left[0] >= 8 && left[1] >= 8 && left[2] >= 8 && left[3] >= 8) {
+            for (int s = 0; s < kStreams; ++s) br[s].refill();
+            for (int k = 0; k < 4; ++k) {
+                for (int s = 0; s < kStreams; ++s) {
+                    const TableEntry e = t[br[s].buf & kTableMask];
+                    dst[s][0] = (uint8_t)e.symbols;
+                    dst[s][1] = (uint8_t)(e.symbols >> 8);
+                    dst[s] += e.count;
+                    left[s] -= e.count;
+                    br[s].consume(e.bits);
+                }
+            }
+            if (br[0].overrun() || br[1].overrun() || br[2].overrun() || br[3].overrun()) return false;
+        }
+        // Tails one stream at a time
+        for (int s = 0; s < kStreams; ++s) {
+            if (decodeSymbols(tree, t, br[s], dst[s], left[s]) != left[s] || br[s].overrun()) return false;
+        }
+        return true;
     }
-    size_t bytePos() const { return pos; }
 };
 
-// Public API implementations
-namespace Huffman {
+// --- Parallel decoding of a single stream (HUF1/HUF2 carry no block index) ---
+// Huffman codes self-synchronize: a decoder started at an arbitrary bit soon
+// lands on a symbol boundary of the true parse and from there on agrees with
+// it. The stream is cut into chunks at byte offsets and decoded in three steps:
+//  1. every chunk, in parallel, is parsed from its cut (a guess) to the first
+//     boundary past its end, counting symbols and keeping the first boundaries
+//     it passes (one per table lookup) with the count so far
+//  2. in order, the true parse is walked symbol by symbol from where the previous
+//     chunk really ended until it meets one of those boundaries: from there the
+//     chunk's count and end are right; a chunk that never meets one is parsed to
+//     its end the same way (correct, only slower)
+//  3. with true starts and output offsets known, every chunk is decoded straight
+//     into the output, in parallel
+static constexpr size_t kSyncChunk = 1 << 20;   // least compressed bytes per chunk
+static constexpr size_t kSyncWindow = 4096;     // boundaries a chunk keeps for step 2
+
+struct SyncChunk {
+    uint64_t start = 0, stop = 0;   // cut and next cut, in bits
+    uint64_t end = 0;               // first boundary at or past stop
+    uint64_t symbols = 0;           // symbols from start to end
+    std::vector<uint64_t> marks;    // boundaries passed, with the symbol count at each
+    std::vector<uint64_t> counts;
+};
 
-bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary) {
-    if (input.empty()) return false;
+// Step 1: count symbols from the chunk's cut without writing them
+static void scanChunk(const Decoder& d, const uint8_t* data, size_t size, SyncChunk& c) {
+    BitBuffer br(data, size, (size_t)(c.start / 8));
+    br.refill();
+    br.consume((int)(c.start % 8));
+    uint64_t symbols = 0;
+    for (;;) {
+        uint64_t bit = br.bitPosition();
+        if (bit >= c.stop || br.overrun()) {
+            c.end = bit;
+            break;
+        }
+        if (c.marks.size() < kSyncWindow) {
+            c.marks.push_back(bit);
+            c.counts.push_back(symbols);
+        }
+        if (br.count < kTableBits) br.refill();
+        const TableEntry e = d.table[br.buf & kTableMask];
+        if (e.count == 0) {
+            int node = e.symbols;
+            br.consume(kTableBits);
+            while (d.tree.child[node][0] != 0) {
+                if (br.count == 0) br.refill();
+                node = d.tree.child[node][br.buf & 1];
+                br.consume(1);
+            }
+            symbols++;
+        } else {
+            br.consume(e.bits);
+            symbols += e.count;
+        }
+    }
+    c.symbols = symbols;
+    c.marks.push_back(c.end);
+    c.counts.push_back(symbols);
+}
 
-    // Frequency counting (DSA): O(n)
+// Step 2: true end and symbol count of chunk c, whose true parse starts at `from`
+static void syncChunk(const Decoder& d, const uint8_t* data, size_t size, uint64_t from, SyncChunk& c) {
+    BitBuffer br(data, size, (size_t)(from / 8));
+    br.refill();
+    br.consume((int)(from % 8));
+    uint64_t symbols = 0;
+    size_t next = 0;
+    for (;;) {
+        uint64_t bit = br.bitPosition();
+        while (next < c.marks.size() && c.marks[next] < bit) next++;
+        if (next < c.marks.size() && c.marks[next] == bit) {
+            // Converged: the speculative parse is the true one from here on
+            c.symbols = symbols + (c.symbols - c.counts[next]);
+            return;
+        }
+        if (bit >= c.stop || br.overrun()) {
+            c.end = bit;
+            c.symbols = symbols;
+            return;
+        }
+        int node = 0;
+        while (d.tree.child[node][0] != 0) {
+            if (br.count == 0) br.refill();
+            node = d.tree.child[node][br.buf & 1];
+            br.consume(1);
+        }
+        symbols++;
+    }
+}
+
+// Decodes n symbols of the stream data[pos, size) on the worker pool; false when
+// the stream is too short to split (the caller decodes it on one thread)
+static bool decodeParallel(const Decoder& d, const uint8_t* data, size_t size, size_t pos, uint8_t* out,
+                           uint64_t n, int threads, ProgressTracker& progress, bool& ok) {
+    if (threads <= 0) threads = Parallel::defaultThreads();
+    size_t chunks = std::min((size - pos) / kSyncChunk, (size_t)threads * 4);
+    // Scanning costs about as much as decoding, so two threads would only break even
+    if (threads < 3 || chunks < 2) return false;
+
+    size_t chunkBytes = (size - pos) / chunks;
+    std::vector<SyncChunk> c(chunks);
+    for (size_t k = 0; k < chunks; ++k) {
+        c[k].start = (uint64_t)(pos + k * chunkBytes) * 8;
+        c[k].stop = k + 1 < chunks ? (uint64_t)(pos + (k + 1) * chunkBytes) * 8 : (uint64_t)size * 8;
+    }
+    Parallel::forEach(chunks, threads, [&](size_t k) { scanChunk(d, data, size, c[k]); });
+
+    // Chunk 0 starts on the true parse; every later one is synced to its predecessor.
+    // The last chunk holds whatever the others did not.
+    std::vector<uint64_t> offsets(chunks);
+    uint64_t total = 0;
+    for (size_t k = 0; k < chunks; ++k) {
+        if (k > 0) {
+            syncChunk(d, data, size, c[k - 1].end, c[k]);
+            c[k].start = c[k - 1].end;
+        }
+        offsets[k] = total;
+        if (k + 1 == chunks) {
+            if (total > n) { ok = false; return true; }
+            c[k].symbols = n - total;
+        }
+        total += c[k].symbols;
+    }
+    if (total != n) { ok = false; return true; }
+
+    std::atomic<bool> good(true);
+    Parallel::forEach(chunks, threads, [&](size_t k) {
+        if (!good) return;
+        BitBuffer br(data, size, (size_t)(c[k].start / 8));
+        br.refill();
+        br.consume((int)(c[k].start % 8));
+        size_t count = (size_t)c[k].symbols;
+        if (decodeSymbols(d.tree, d.table.data(), br, out + offsets[k], count) != count || br.overrun() ||
+            (k + 1 < chunks && br.bitPosition() != c[k].end) || !progress.advance(count)) good = false;
+    });
+    ok = good;
+    return true;
+}
+
+// --- Block container (HUFB) ---
+// "HUFB" (4) | block size (4) | flags (1), bit 0 = a shared code length table follows,
+//          bit 1 = blocks and the end mark carry CRC-32C checksums ([...] below)
+// blocks:  mode (1) | raw size (4) | payload size (4) | [CRC-32C of the raw block (4)] | payload
+//          mode 0 payload = own code length table + bitstream
+//          mode 1 payload = bitstream coded with the shared table
+//          mode 2 payload = own code length table + jump table + 4 bitstreams
+//          mode 3 payload = jump table + 4 bitstreams coded with the shared table
+//          mode 4 payload = the raw bytes (stored: Huffman would not make them smaller)
+//          mode 5 payload = the one byte value the whole block repeats (RLE)
+// end:     mode 0xFF | [file checksum (4): CRC-32C of the block CRCs in order]
+// index:   block count (4) | file offset of every block header (8 each)
+// footer:  original size (8) | index offset (8)
+// Every block but the last holds exactly `block size` input bytes, so block i
+// starts at i * blockSize in the output and all blocks decode independently.
+enum : uint8_t {
+    kBlockHuffman = 0, kBlockShared = 1, kBlockHuffman4 = 2, kBlockShared4 = 3, kBlockStored = 4, kBlockRle = 5,
+    kBlockEnd = 0xFF
+};
+enum : uint8_t { kFlagSharedTable = 1, kFlagChecksums = 2 };
+static constexpr size_t kFooterSize = 16;
+
+static bool isInterleaved(const Huffman::Options& options) {
+    return options.format == Huffman::Format::Interleaved;
+}
+
+static uint8_t blockMode(bool shared, bool interleaved) {
+    return interleaved ? (shared ? kBlockShared4 : kBlockHuffman4) : (shared ? kBlockShared : kBlockHuffman);
+}
+
+// Interleaved blocks cap their codes at the lookup table width, so the 4-stream
+// decoder never has to fall back to the tree
+static int blockCodeLimit(const Huffman::Options& options) {
+    if (!isInterleaved(options)) return options.maxCodeLength;
+    return options.maxCodeLength > 0 ? std::min(options.maxCodeLength, kTableBits) : kTableBits;
+}
+
+// Everything encodeBlock needs to write a block, worked out from its histograms
+// before any bit is written: the mode, the exact payload size and the own codes
+struct BlockPlan {
+    uint8_t mode = 0;
+    size_t payloadBytes = 0;
+    CodeSet own;
     std::array<uint64_t, 256> freq{};
-    for (uint8_t b : input) freq[b]++;
+    std::array<uint64_t, 256> quarterFreq[kStreams];
+};
 
-    // Create nodes for bytes with non-zero freq
-    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, Cmp> pq;
-    uint32_t distinct = 0;
-    for (int i = 0; i < 256; ++i) {
-        if (freq[i]) {
-            pq.push(std::make_shared<Node>(static_cast<uint8_t>(i), freq[i]));
-            distinct++;
+// A run when the block is one byte value repeated, stored when the Huffman payload
+// (bits of every symbol, the own code table, for 4 streams the jump table and each
+// stream's partial byte) would be no smaller than the block, else Huffman
+static bool planBlock(const uint8_t* block, size_t len, int maxCodeLength, const CodeSet* shared,
+                      bool interleaved, BlockPlan& plan) {
+    // The block histogram is the sum of the quarter ones: still one pass
+    plan.freq.fill(0);
+    if (interleaved) {
+        size_t quarter = (len + kStreams - 1) / kStreams;
+        for (int s = 0; s < kStreams; ++s) {
+            size_t begin = std::min(len, s * quarter);
+            plan.quarterFreq[s] = Histogram::count(block + begin, std::min(len, begin + quarter) - begin);
+            for (int i = 0; i < 256; ++i) plan.freq[i] += plan.quarterFreq[s][i];
         }
+    } else {
+        plan.freq = Histogram::count(block, len);
     }
 
-    // Edge: if only one distinct symbol, still create tree
-    if (pq.size() == 1) {
-        auto only = pq.top(); pq.pop();
-        // create a dummy sibling so tree traversal yields a code
-        auto dummy = std::make_shared<Node>(0, 0);
-        pq.push(std::make_shared<Node>(only, dummy));
+    if (plan.freq[block[0]] == len) {
+        plan.mode = kBlockRle;
+        plan.payloadBytes = 1;
+        return true;
+    }
+    if (!shared && !buildCanonicalCodes(plan.freq, maxCodeLength, plan.own)) return false;
+    const CodeSet& cs = shared ? *shared : plan.own;
+    size_t bytes = shared ? 0 : lengthsBytes(plan.own);
+    if (interleaved) {
+        bytes += kJumpTableSize;
+        for (int s = 0; s < kStreams; ++s) bytes += streamBytesOf(plan.quarterFreq[s], cs.lengths);
+    } else {
+        bytes += streamBytesOf(plan.freq, cs.lengths);
     }
+    if (bytes >= len) {
+        plan.mode = kBlockStored;
+        plan.payloadBytes = len;
+        return true;
+    }
+    plan.mode = blockMode(shared != nullptr, interleaved);
+    plan.payloadBytes = bytes;
+    return true;
+}
 
-    // Build Huffman tree (DSA: min-heap merging) O(m log m)
-    while (pq.size() > 1) {
-        auto a = pq.top(); pq.pop();
-        auto b = pq.top(); pq.pop();
-        pq.push(std::make_shared<Node>(a, b));
+// Payload of one block as planned: the byte of a run, the block as is, or own code
+// table + bitstream(s) (the bitstream(s) alone when a shared table is given)
+static bool encodeBlock(const uint8_t* block, size_t len, int maxCodeLength, const CodeSet* shared,
+                        bool interleaved, uint8_t& mode, std::vector<uint8_t>& payload) {
+    payload.clear();
+    BlockPlan plan;
+    if (!planBlock(block, len, maxCodeLength, shared, interleaved, plan)) return false;
+    mode = plan.mode;
+    if (mode == kBlockRle) {
+        payload.push_back(block[0]);
+        return true;
+    }
+    if (mode == kBlockStored) {
+        payload.assign(block, block + len);
+        return true;
     }
-    auto root = pq.top();
 
-    // Build codes (DSA: DFS)
-    std::array<std::string, 256> codes;
-    std::string cur;
-    buildCodes(root, cur, codes);
+    payload.reserve(plan.payloadBytes + 8);
+    const CodeSet& cs = shared ? *shared : plan.own;
+    if (!shared) writeLengths(payload, plan.own);
+    if (interleaved) return appendInterleaved(block, len, plan.quarterFreq, cs, payload);
+    return appendStream(block, len, plan.freq, cs.bits, cs.lengths, cs.maxLen, payload);
+}
 
-    // Output header:
-    // magic "HUF1" (4 bytes), original size (8 bytes), distinct count (4 bytes)
-    outBinary.clear();
-    outBinary.reserve(input.size()/2);
-    outBinary.push_back('H'); outBinary.push_back('U'); outBinary.push_back('F'); outBinary.push_back('1');
-    writeUint64(outBinary, (uint64_t)input.size());
-    writeUint32(outBinary, distinct);
+// Decodes the payload in[pos, end) of one block into dst (raw bytes)
+static bool decodeBlock(uint8_t mode, const uint8_t* in, size_t end, size_t pos, const Decoder* shared,
+                        uint8_t* dst, uint64_t raw) {
+    if (mode == kBlockStored) {
+        if (end - pos != raw) return false;
+        std::memcpy(dst, in + pos, (size_t)raw);
+        return true;
+    }
+    if (mode == kBlockRle) {
+        if (end - pos != 1) return false;
+        std::memset(dst, in[pos], (size_t)raw);
+        return true;
+    }
+    bool interleaved = mode == kBlockHuffman4 || mode == kBlockShared4;
+    if (mode == kBlockShared || mode == kBlockShared4) {
+        if (!shared) return false;
+        return interleaved ? shared->decode4(in, end, pos, dst, raw) : shared->decode(in, end, pos, dst, raw);
+    }
+    if (mode != kBlockHuffman && mode != kBlockHuffman4) return false;
+    std::array<uint8_t, 256> lengths;
+    Decoder decoder;
+    if (!readLengths(in, end, pos, lengths) || !decoder.initCanonical(lengths)) return false;
+    return interleaved ? decoder.decode4(in, end, pos, dst, raw) : decoder.decode(in, end, pos, dst, raw);
+}
 
-    // For each distinct byte: 1 byte value + 8 bytes frequency
-    for (int i = 0; i < 256; ++i) {
-        if (freq[i]) {
-            outBinary.push_back((uint8_t)i);
-            writeUint64(outBinary, freq[i]);
+static void writeBlockHeader(std::vector<uint8_t>& out, uint8_t mode, size_t rawSize, size_t payloadSize,
+                             bool checked, uint32_t crc) {
+    out.push_back(mode);
+    writeUint32(out, (uint32_t)rawSize);
+    writeUint32(out, (uint32_t)payloadSize);
+    if (checked) writeUint32(out, crc);
+}
+
+// End marker, file checksum, block index and footer
+static void writeBlockTrailer(std::vector<uint8_t>& out, uint64_t endOffset, const std::vector<uint64_t>& offsets,
+                              uint64_t originalSize, bool checked, uint32_t fileCrc) {
+    out.push_back(kBlockEnd);
+    if (checked) writeUint32(out, fileCrc);
+    writeUint32(out, (uint32_t)offsets.size());
+    for (uint64_t off : offsets) writeUint64(out, off);
+    writeUint64(out, originalSize);
+    writeUint64(out, endOffset + 1 + (checked ? kChecksumSize : 0));
+}
+
+// Container bytes around the payloads: magic, block size and flags, the shared
+// table, a header per block, the end marker, the block index and the footer
+static size_t blocksOverhead(size_t count, const CodeSet* shared, bool checked) {
+    size_t check = checked ? kChecksumSize : 0;
+    return 9 + (shared ? lengthsBytes(*shared) : 0) + count * (kBlockHeaderSize + check + 8) + 1 + check + 4 +
+           kFooterSize;
+}
+
+static bool compressBlocks(const uint8_t* data, size_t n, const Huffman::Options& options, std::vector<uint8_t>& out) {
+    ProgressTracker progress(options.progress, n);
+    size_t blockSize = clampBlockSize(options.blockSize);
+    size_t count = (n + blockSize - 1) / blockSize;
+
+    bool interleaved = isInterleaved(options);
+    int codeLimit = blockCodeLimit(options);
+    CodeSet shared;
+    if (options.sharedTable) {
+        std::array<uint64_t, 256> freq = Histogram::count(data, n, options.threads);
+        if (!buildCanonicalCodes(freq, codeLimit, shared)) return false;
+    }
+
+    // Each worker builds its block's payload independently
+    std::vector<std::vector<uint8_t>> payloads(count);
+    std::vector<uint8_t> modes(count);
+    std::vector<uint32_t> crcs(count);
+    std::atomic<bool> ok(true);
+    Parallel::forEach(count, options.threads, [&](size_t i) {
+        if (!ok) return; // failed or cancelled: skip the remaining blocks
+        size_t len = std::min(blockSize, n - i * blockSize);
+        if (options.checksums) crcs[i] = Checksum::crc32c(data + i * blockSize, len);
+        if (!encodeBlock(data + i * blockSize, len, codeLimit,
+                         options.sharedTable ? &shared : nullptr, interleaved, modes[i], payloads[i]) ||
+            !progress.advance(len)) ok = false;
+    });
+    if (!ok) return false;
+
+    size_t total = blocksOverhead(count, options.sharedTable ? &shared : nullptr, options.checksums);
+    for (auto& p : payloads) total += p.size();
+    out.clear();
+    out.reserve(total);
+    out.push_back('H'); out.push_back('U'); out.push_back('F'); out.push_back('B');
+    writeUint32(out, (uint32_t)blockSize);
+    out.push_back((options.sharedTable ? kFlagSharedTable : 0) | (options.checksums ? kFlagChecksums : 0));
+    if (options.sharedTable) writeLengths(out, shared);
+
+    std::vector<uint64_t> offsets(count);
+    uint32_t fileCrc = 0;
+    for (size_t i = 0; i < count; ++i) {
+        offsets[i] = out.size();
+        writeBlockHeader(out, modes[i], std::min(blockSize, n - i * blockSize), payloads[i].size(),
+                         options.checksums, crcs[i]);
+        out.insert(out.end(), payloads[i].begin(), payloads[i].end());
+        std::vector<uint8_t>().swap(payloads[i]);
+        fileCrc = chainCrc(fileCrc, crcs[i]);
+    }
+    writeBlockTrailer(out, out.size(), offsets, n, options.checksums, fileCrc);
+    return true;
+}
+
+// Header, shared table and block index of an in-memory HUFB file: enough to
+// find and decode any block on its own
+struct BlocksView {
+    size_t blockSize = 0;
+    size_t dataStart = 0;       // first byte after the header (and shared table)
+    bool hasShared = false;
+    bool checked = false;       // block CRCs and a file checksum
+    Decoder shared;
+    uint64_t originalSize = 0;
+    uint64_t indexOffset = 0;
+    std::vector<uint64_t> offsets;
+};
+
+static bool readBlocksView(const uint8_t* in, size_t size, BlocksView& v) {
+    if (size < 9 + 1 + 4 + kFooterSize) return false;
+    size_t pos = 4;
+    v.blockSize = readUint32(in, pos);
+    uint8_t flags = in[pos++];
+    if (v.blockSize < kMinBlockSize || v.blockSize > kMaxBlockSize) return false;
+
+    v.hasShared = (flags & kFlagSharedTable) != 0;
+    v.checked = (flags & kFlagChecksums) != 0;
+    if (v.hasShared) {
+        std::array<uint8_t, 256> lengths;
+        if (!readLengths(in, size, pos, lengths) || !v.shared.initCanonical(lengths)) return false;
+    }
+    v.dataStart = pos;
+
+    // Footer and block index; offsets and sizes from the file are untrusted, so every
+    // bound is checked by subtracting from a known size, never by adding to them
+    size_t footer = size - kFooterSize;
+    v.originalSize = readUint64(in, footer);
+    v.indexOffset = readUint64(in, footer);
+    if (v.indexOffset < pos || v.indexOffset > size - kFooterSize - 4) return false;
+    size_t ipos = (size_t)v.indexOffset;
+    uint64_t count = readUint32(in, ipos);
+    if (count != (size - kFooterSize - ipos) / 8 || (size - kFooterSize - ipos) % 8 != 0) return false;
+    if (count != v.originalSize / v.blockSize + (v.originalSize % v.blockSize != 0)) return false;
+    v.offsets.resize(count);
+    for (auto& off : v.offsets) off = readUint64(in, ipos);
+    if (!v.checked) return true;
+
+    // The block CRCs chained in order must give the file checksum after the end mark
+    if (v.indexOffset < pos + kChecksumSize) return false;
+    uint32_t fileCrc = 0;
+    for (uint64_t off : v.offsets) {
+        if (off < pos || off > v.indexOffset - kBlockHeaderSize - kChecksumSize) return false;
+        size_t cpos = (size_t)off + kBlockHeaderSize;
+        fileCrc = chainCrc(fileCrc, readUint32(in, cpos));
+    }
+    size_t cpos = (size_t)v.indexOffset - kChecksumSize;
+    return readUint32(in, cpos) == fileCrc;
+}
+
+// HUFB's version of the shared container's decodeBlocks: blocks are found through the
+// file's index rather than by hopping, so each worker re-checks its block header against
+// the index bounds before decoding (null out: verify into per-worker scratch)
+static bool decodeBlocks(const uint8_t* in, const BlocksView& v, size_t first, size_t last, int threads,
+                         uint8_t* out, ProgressTracker& progress) {
+    size_t header = kBlockHeaderSize + (v.checked ? kChecksumSize : 0);
+    std::atomic<bool> ok(true);
+    Parallel::forEach(last - first, threads, [&](size_t k) {
+        if (!ok) return;
+        thread_local std::vector<uint8_t> scratch;
+        size_t i = first + k;
+        size_t bpos = (size_t)v.offsets[i];
+        if (bpos < v.dataStart || bpos > v.indexOffset || v.indexOffset - bpos < header) { ok = false; return; }
+        uint8_t mode = in[bpos++];
+        uint64_t raw = readUint32(in, bpos);
+        uint64_t payload = readUint32(in, bpos);
+        uint32_t crc = v.checked ? readUint32(in, bpos) : 0;
+        uint64_t expected = std::min<uint64_t>(v.blockSize, v.originalSize - i * v.blockSize);
+        size_t end = bpos + (size_t)payload;
+        if (raw != expected || payload > v.indexOffset - bpos) { ok = false; return; }
+
+        if (!out && scratch.size() < raw) scratch.resize((size_t)raw);
+        uint8_t* dst = out ? out + k * v.blockSize : scratch.data();
+        if (!decodeBlock(mode, in, end, bpos, v.hasShared ? &v.shared : nullptr, dst, raw) ||
+            (v.checked && Checksum::crc32c(dst, (size_t)raw) != crc) || !progress.advance(raw)) ok = false;
+    });
+    return ok;
+}
+
+static bool decompressBlocks(const uint8_t* in, size_t size, int threads, uint8_t* out, size_t outSize,
+                             Huffman::Progress* sink) {
+    BlocksView v;
+    if (!readBlocksView(in, size, v) || v.originalSize != outSize) return false;
+    ProgressTracker progress(sink, v.originalSize);
+    return decodeBlocks(in, v, 0, v.offsets.size(), threads, out, progress);
+}
+
+// Codes and header of a single-stream file (HUF1 or HUF2) from its histogram
+static bool buildStreamHeader(const std::array<uint64_t, 256>& freq, uint64_t size, const Huffman::Options& options,
+                              std::vector<uint8_t>& header, CodeSet& sc) {
+    if (options.format == Huffman::Format::Legacy) {
+        uint32_t distinct = 0;
+        for (int i = 0; i < 256; ++i) if (freq[i]) distinct++;
+
+        // Build codes (DSA: DFS) as (bits, length) pairs
+        HuffTree tree;
+        if (!buildLegacyTree(freq, tree)) return false;
+        buildCodes(tree, sc.bits, sc.lengths, sc.maxLen);
+        if (sc.maxLen > kMaxCodeLength) return false;
+
+        // Output header:
+        // magic "HUF1" (4 bytes), original size (8 bytes), distinct count (4 bytes)
+        header.reserve(16 + 9 * distinct);
+        header.push_back('H'); header.push_back('U'); header.push_back('F'); header.push_back('1');
+        writeUint64(header, size);
+        writeUint32(header, distinct);
+
+        // For each distinct byte: 1 byte value + 8 bytes frequency
+        for (int i = 0; i < 256; ++i) {
+            if (freq[i]) {
+                header.push_back((uint8_t)i);
+                writeUint64(header, freq[i]);
+            }
         }
+        return true;
     }
 
-    // Now write the bitstream using codes
-    BitWriter bw(outBinary);
-    for (uint8_t b : input) {
-        bw.writeBitsFromString(codes[b]);
+    if (!buildCanonicalCodes(freq, options.maxCodeLength, sc)) return false;
+
+    // Output header:
+    // magic "HUF2" (4 bytes), original size (8 bytes), code length table
+    header.reserve(14 + 256);
+    header.push_back('H'); header.push_back('U'); header.push_back('F'); header.push_back('2');
+    writeUint64(header, size);
+    writeLengths(header, sc);
+    return true;
+}
+
+// --- Pre-flight size estimate ---
+// Inputs above kSampleAbove are estimated from kSamples strided regions (whole
+// blocks for HUFB, kSampleRegion bytes otherwise) instead of every byte
+static constexpr size_t kSampleAbove = 64 << 20;
+static constexpr size_t kSamples = 16;
+static constexpr size_t kSampleRegion = 1 << 20;
+
+static double entropyOf(const std::array<uint64_t, 256>& freq) {
+    uint64_t total = 0;
+    for (uint64_t f : freq) total += f;
+    double bits = 0;
+    for (uint64_t f : freq) {
+        if (!f) continue;
+        double p = (double)f / (double)total;
+        bits -= p * std::log2(p);
     }
-    bw.flush();
+    return bits;
+}
+
+// Header + bitstream of a single-stream file with this histogram, O(256)
+static bool streamSize(const std::array<uint64_t, 256>& freq, uint64_t size, const Huffman::Options& options,
+                       uint64_t& outSize) {
+    Huffman::Options single = options;
+    if (single.format != Huffman::Format::Legacy) single.format = Huffman::Format::Canonical;
+    std::vector<uint8_t> header;
+    CodeSet sc;
+    if (!buildStreamHeader(freq, size, single, header, sc)) return false;
+    outSize = header.size() + streamBytesOf(freq, sc.lengths);
     return true;
 }
 
-bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes) {
-    size_t pos = 0;
-    if (inBinary.size() < 4) return false;
-    if (inBinary[pos] != 'H' || inBinary[pos+1] != 'U' || inBinary[pos+2] != 'F' || inBinary[pos+3] != '1') return false;
-    pos += 4;
-    uint64_t originalSize = readUint64(inBinary, pos);
-    uint32_t distinct = readUint32(inBinary, pos);
+// Single stream: histogram of the input (or of the samples, scaled up to the input)
+static bool estimateStream(const uint8_t* input, size_t size, const Huffman::Options& options,
+                           Huffman::Estimate& out) {
+    std::array<uint64_t, 256> freq{};
+    if (size <= kSampleAbove) {
+        freq = Histogram::count(input, size, options.threads);
+    } else {
+        // Spread from the first region to the last one, both ends included
+        for (size_t i = 0; i < kSamples; ++i)
+            Histogram::accumulate(input + i * ((size - kSampleRegion) / (kSamples - 1)), kSampleRegion, freq);
+        double scale = (double)size / (double)(kSamples * kSampleRegion);
+        for (uint64_t& f : freq)
+            if (f) f = std::max<uint64_t>(1, (uint64_t)((double)f * scale));
+        out.exact = false;
+    }
+    out.entropy = entropyOf(freq);
+    return streamSize(freq, size, options, out.compressedSize);
+}
+
+// HUFB: every block planned as compressBytes would (mode and payload size), or
+// kSamples strided blocks whose average stands for all of them
+static bool estimateBlocks(const uint8_t* input, size_t size, const Huffman::Options& options,
+                           Huffman::Estimate& out) {
+    size_t blockSize = clampBlockSize(options.blockSize);
+    size_t count = (size + blockSize - 1) / blockSize;
+    bool sample = size > kSampleAbove && count > kSamples;
+    std::vector<size_t> picked;
+    if (sample) {
+        // Whole blocks only, so the last (short) one is never a sample
+        for (size_t i = 0; i < kSamples; ++i) picked.push_back(i * (count - 2) / (kSamples - 1));
+    } else {
+        for (size_t i = 0; i < count; ++i) picked.push_back(i);
+    }
+    auto blockLen = [&](size_t i) { return std::min(blockSize, size - i * blockSize); };
+
+    std::array<uint64_t, 256> freq{};
+    if (!sample) {
+        freq = Histogram::count(input, size, options.threads);
+    } else {
+        for (size_t i : picked) Histogram::accumulate(input + i * blockSize, blockLen(i), freq);
+    }
+    out.entropy = entropyOf(freq);
+
+    bool interleaved = isInterleaved(options);
+    int codeLimit = blockCodeLimit(options);
+    CodeSet shared;
+    if (options.sharedTable && !buildCanonicalCodes(freq, codeLimit, shared)) return false;
+
+    std::vector<size_t> payloads(picked.size());
+    std::atomic<bool> ok(true);
+    Parallel::forEach(picked.size(), options.threads, [&](size_t k) {
+        if (!ok) return;
+        BlockPlan plan;
+        size_t i = picked[k];
+        if (!planBlock(input + i * blockSize, blockLen(i), codeLimit, options.sharedTable ? &shared : nullptr,
+                       interleaved, plan)) ok = false;
+        payloads[k] = plan.payloadBytes;
+    });
+    if (!ok) return false;
+
+    uint64_t total = 0;
+    for (size_t p : payloads) total += p;
+    if (sample) {
+        total = (uint64_t)((double)total / (double)picked.size() * (double)count);
+        out.exact = false;
+    }
+    out.compressedSize = total + blocksOverhead(count, options.sharedTable ? &shared : nullptr, options.checksums);
+    return true;
+}
+
+// Public API implementations
+namespace Huffman {
+
+bool estimate(const std::array<uint64_t, 256>& freq, Estimate& out, const Options& options) {
+    uint64_t size = 0;
+    for (uint64_t f : freq) size += f;
+    if (size == 0) return false;
+    out = Estimate();
+    out.entropy = entropyOf(freq);
+    return streamSize(freq, size, options, out.compressedSize);
+}
+
+bool estimate(const uint8_t* input, size_t size, Estimate& out, const Options& options) {
+    if (!input || size == 0) return false;
+    out = Estimate();
+    if (options.format == Format::Blocks || options.format == Format::Interleaved)
+        return estimateBlocks(input, size, options, out);
+    return estimateStream(input, size, options, out);
+}
+
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary, const Options& options) {
+    if (!input || size == 0) return false;
+    outBinary.clear();
+
+    if (options.format == Format::Blocks || options.format == Format::Interleaved)
+        return compressBlocks(input, size, options, outBinary);
+
+    // Frequency counting (DSA): O(n), sliced across options.threads for large inputs
+    std::array<uint64_t, 256> freq = Histogram::count(input, size, options.threads);
+
+    // Header and code lengths give the exact output size: one allocation
+    CodeSet sc;
+    std::vector<uint8_t> header;
+    if (!buildStreamHeader(freq, size, options, header, sc)) return false;
+    outBinary.reserve(header.size() + streamBytesOf(freq, sc.lengths) + 8);
+    outBinary.assign(header.begin(), header.end());
+    ProgressTracker progress(options.progress, size);
+    return appendStream(input, size, freq, sc.bits, sc.lengths, sc.maxLen, outBinary, &progress);
+}
+
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary, const Options& options) {
+    return compressBytes(input.data(), input.size(), outBinary, options);
+}
+
+// prefix: outSize may be less than the original size, only the first outSize
+// bytes are decoded (single streams have no index, so ranges start at 0)
+static bool decompressLegacy(const uint8_t* in, size_t size, size_t pos, uint8_t* out, size_t outSize,
+                             Progress* sink, int threads, bool prefix = false) {
+    if (size < 16) return false;
+    uint64_t originalSize = readUint64(in, pos);
+    uint32_t distinct = readUint32(in, pos);
+    if (prefix ? outSize > originalSize : originalSize != outSize) return false;
 
     std::array<uint64_t, 256> freq{};
     for (uint32_t i = 0; i < distinct; ++i) {
-        if (pos + 1 + 8 > inBinary.size()) return false;
-        uint8_t val = inBinary[pos++];
-        uint64_t f = readUint64(inBinary, pos);
+        if (pos + 1 + 8 > size) return false;
+        uint8_t val = in[pos++];
+        uint64_t f = readUint64(in, pos);
         freq[val] = f;
     }
 
-    // Reconstruct tree as in compression: create pq of nodes
-    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, Cmp> pq;
-    for (int i = 0; i < 256; ++i) if (freq[i]) pq.push(std::make_shared<Node>(static_cast<uint8_t>(i), freq[i]));
+    // Reconstruct tree as in compression
+    HuffTree tree;
+    if (!buildLegacyTree(freq, tree)) return false;
+
+    // Flatten the tree once per file
+    Decoder decoder;
+    flattenTree(tree, tree.root(), decoder.tree);
+    decoder.buildTable();
+    if (originalSize > (uint64_t)(size - pos) * 8) return false;
+    ProgressTracker progress(sink, outSize);
+    bool ok = false;
+    if (!prefix && decodeParallel(decoder, in, size, pos, out, outSize, threads, progress, ok)) return ok;
+    return decoder.decode(in, size, pos, out, outSize, &progress);
+}
+
+static bool decompressCanonical(const uint8_t* in, size_t size, size_t pos, uint8_t* out, size_t outSize,
+                                Progress* sink, int threads, bool prefix = false) {
+    if (size < 14) return false;
+    uint64_t originalSize = readUint64(in, pos);
+    if (prefix ? outSize > originalSize : originalSize != outSize) return false;
+
+    std::array<uint8_t, 256> lengths;
+    Decoder decoder;
+    if (!readLengths(in, size, pos, lengths) || !decoder.initCanonical(lengths)) return false;
+    if (originalSize > (uint64_t)(size - pos) * 8) return false;
+    ProgressTracker progress(sink, outSize);
+    bool ok = false;
+    if (!prefix && decodeParallel(decoder, in, size, pos, out, outSize, threads, progress, ok)) return ok;
+    return decoder.decode(in, size, pos, out, outSize, &progress);
+}
+
+// The size is checked against what the buffer can possibly hold, so a bogus one is
+// caught before anyone allocates for it
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize) {
+    if (!in || size < 4) return false;
+    if (in[0] != 'H' || in[1] != 'U' || in[2] != 'F') return false;
+    size_t pos = 4;
+    switch (in[3]) {
+    case '1':
+    case '2':
+        if (size < 12) return false;
+        outSize = readUint64(in, pos);
+        // every output byte costs at least one input bit
+        return outSize <= (uint64_t)size * 8;
+    case 'B': {
+        if (size < 9 + 1 + 4 + kFooterSize) return false;
+        uint64_t blockSize = readUint32(in, pos);
+        if (blockSize < kMinBlockSize || blockSize > kMaxBlockSize) return false;
+        pos = size - kFooterSize;
+        outSize = readUint64(in, pos);
+        uint64_t indexOffset = readUint64(in, pos);
+        if (indexOffset < 9 || indexOffset > size - kFooterSize - 4) return false;
+        // run blocks expand without limit, but each block has an entry in the index
+        uint64_t entries = (size - kFooterSize - 4 - indexOffset) / 8;
+        return outSize <= entries * blockSize;
+    }
+    default:
+        return false;
+    }
+}
 
-    if (pq.empty()) return false;
-    if (pq.size() == 1) {
-        auto only = pq.top(); pq.pop();
-        auto dummy = std::make_shared<Node>(0, 0);
-        pq.push(std::make_shared<Node>(only, dummy));
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads, Progress* progress) {
+    if (!in || size < 4 || (!out && outSize)) return false;
+    if (in[0] != 'H' || in[1] != 'U' || in[2] != 'F') return false;
+    switch (in[3]) {
+    case '1': return decompressLegacy(in, size, 4, out, outSize, progress, threads);
+    case '2': return decompressCanonical(in, size, 4, out, outSize, progress, threads);
+    case 'B': return decompressBlocks(in, size, threads, out, outSize, progress);
+    default: return false;
     }
-    while (pq.size() > 1) {
-        auto a = pq.top(); pq.pop();
-        auto b = pq.top(); pq.pop();
-        pq.push(std::make_shared<Node>(a, b));
+}
+
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads) {
+    uint64_t originalSize = 0;
+    if (!decompressedSize(in, size, originalSize) || offset > originalSize) return false;
+    length = (size_t)std::min<uint64_t>(length, originalSize - offset);
+    out.clear();
+    if (length == 0) return true;
+
+    if (in[3] != 'B') {
+        // Single stream: decode up to the end of the range, keep its tail
+        std::vector<uint8_t> prefix((size_t)(offset + length));
+        bool ok = in[3] == '1' ? decompressLegacy(in, size, 4, prefix.data(), prefix.size(), nullptr, threads, true)
+                               : decompressCanonical(in, size, 4, prefix.data(), prefix.size(), nullptr, threads, true);
+        if (!ok) return false;
+        out.assign(prefix.begin() + (size_t)offset, prefix.end());
+        return true;
     }
-    auto root = pq.top();
 
-    // Now read bits and traverse tree to produce bytes
-    BitReader br(inBinary, pos);
+    // Blocks: the index gives every block's offset, only the covering ones are decoded
+    BlocksView v;
+    if (!readBlocksView(in, size, v)) return false;
+    size_t first = (size_t)(offset / v.blockSize);
+    size_t last = (size_t)((offset + length - 1) / v.blockSize) + 1;
+    uint64_t begin = (uint64_t)first * v.blockSize;
+    std::vector<uint8_t> blocks((size_t)(std::min<uint64_t>(v.originalSize, (uint64_t)last * v.blockSize) - begin));
+    ProgressTracker progress(nullptr, blocks.size());
+    if (!decodeBlocks(in, v, first, last, threads, blocks.data(), progress)) return false;
+    out.assign(blocks.begin() + (size_t)(offset - begin), blocks.begin() + (size_t)(offset - begin) + length);
+    return true;
+}
+
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads, Progress* progress) {
+    uint64_t originalSize = 0;
+    if (!decompressedSize(in, size, originalSize)) return false;
     outBytes.clear();
-    outBytes.reserve((size_t)originalSize);
+    outBytes.resize((size_t)originalSize);
+    return decompressTo(in, size, outBytes.data(), outBytes.size(), threads, progress);
+}
+
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads) {
+    return decompressBytes(inBinary.data(), inBinary.size(), outBytes, threads);
+}
+
+// --- Streaming API ---
+static constexpr size_t kStreamChunk = 1 << 20;
+
+// Passes writes through while counting bytes, so block offsets need no seeking
+class CountingOutput {
+    OutputStream& out;
+public:
+    uint64_t written = 0;
+    explicit CountingOutput(OutputStream& o): out(o) {}
+    bool write(const uint8_t* data, size_t size) {
+        written += size;
+        return size == 0 || out.write(data, size);
+    }
+    bool write(const std::vector<uint8_t>& v) { return write(v.data(), v.size()); }
+};
+
+// Pass 1 builds the histogram, pass 2 encodes chunk by chunk with the bit
+// accumulator carried across chunks
+static bool compressTwoPass(InputStream& in, OutputStream& out, const Options& options) {
+    std::vector<uint8_t> chunk(kStreamChunk);
+    std::array<uint64_t, 256> freq{};
+    uint64_t total = 0;
+    for (size_t n; (n = readFully(in, chunk.data(), chunk.size())) > 0; total += n)
+        Histogram::accumulate(chunk.data(), n, freq);
+    if (total == 0 || !in.rewind()) return false;
+
+    std::vector<uint8_t> header;
+    CodeSet sc;
+    if (!buildStreamHeader(freq, total, options, header, sc)) return false;
+    CountingOutput sink(out);
+    if (!sink.write(header)) return false;
+
+    // worst case: every byte of the chunk gets a maxLen-bit code
+    std::vector<uint8_t> encoded(chunk.size() * (size_t)sc.maxLen / 8 + 16);
+    BitState state;
+    uint64_t seen = 0;
+    ProgressTracker progress(options.progress, total);
+    for (size_t n; (n = readFully(in, chunk.data(), chunk.size())) > 0; seen += n) {
+        size_t bytes = encodeSymbols(chunk.data(), n, sc.bits.data(), sc.lengths.data(), sc.maxLen,
+                                     encoded.data(), state);
+        if (!sink.write(encoded.data(), bytes) || !progress.advance(n)) return false;
+    }
+    if (state.count) {
+        uint8_t last = (uint8_t)state.acc;
+        if (!sink.write(&last, 1)) return false;
+    }
+    return seen == total; // the input changed between the passes otherwise
+}
+
+// HUFB written as blocks arrive; up to `threads` blocks are coded at a time
+static bool compressBlocksStream(InputStream& in, OutputStream& out, const Options& options, bool rewindable) {
+    size_t blockSize = clampBlockSize(options.blockSize);
+    size_t batch = (size_t)(options.threads > 0 ? options.threads : Parallel::defaultThreads());
+    std::vector<std::vector<uint8_t>> raw(batch, std::vector<uint8_t>(blockSize));
+    std::vector<std::vector<uint8_t>> payloads(batch);
+    std::vector<uint8_t> modes(batch);
+    std::vector<uint32_t> crcs(batch);
+    std::vector<size_t> sizes(batch);
+
+    // A shared table needs the whole histogram first, so only rewindable input gets one
+    bool shared = options.sharedTable && rewindable;
+    bool interleaved = isInterleaved(options);
+    int codeLimit = blockCodeLimit(options);
+    CodeSet sharedCodes;
+    if (shared) {
+        std::array<uint64_t, 256> freq{};
+        for (size_t n; (n = readFully(in, raw[0].data(), blockSize)) > 0;)
+            Histogram::accumulate(raw[0].data(), n, freq);
+        if (!in.rewind() || !buildCanonicalCodes(freq, codeLimit, sharedCodes)) return false;
+    }
 
-    std::shared_ptr<Node> cur = root;
-    while (outBytes.size() < originalSize) {
-        int bit = br.readBit();
-        if (bit < 0) return false; // incomplete
-        cur = (bit == 0) ? cur->left : cur->right;
-        if (!cur->left && !cur->right) {
-            // leaf
-            outBytes.push_back(cur->byteVal);
-            cur = root;
+    std::vector<uint8_t> head;
+    head.push_back('H'); head.push_back('U'); head.push_back('F'); head.push_back('B');
+    writeUint32(head, (uint32_t)blockSize);
+    head.push_back((shared ? kFlagSharedTable : 0) | (options.checksums ? kFlagChecksums : 0));
+    if (shared) writeLengths(head, sharedCodes);
+    CountingOutput sink(out);
+    if (!sink.write(head)) return false;
+
+    std::vector<uint64_t> offsets;
+    uint64_t total = 0;
+    uint32_t fileCrc = 0;
+    bool eof = false;
+    ProgressTracker progress(options.progress, 0); // size unknown until the input ends
+    while (!eof) {
+        size_t k = 0;
+        while (k < batch && !eof) {
+            sizes[k] = readFully(in, raw[k].data(), blockSize);
+            eof = sizes[k] < blockSize;
+            if (sizes[k] > 0) ++k;
+        }
+
+        std::atomic<bool> ok(true);
+        Parallel::forEach(k, options.threads, [&](size_t i) {
+            if (options.checksums) crcs[i] = Checksum::crc32c(raw[i].data(), sizes[i]);
+            if (!encodeBlock(raw[i].data(), sizes[i], codeLimit, shared ? &sharedCodes : nullptr, interleaved,
+                             modes[i], payloads[i])) ok = false;
+        });
+        if (!ok) return false;
+
+        for (size_t i = 0; i < k; ++i) {
+            offsets.push_back(sink.written);
+            head.clear();
+            writeBlockHeader(head, modes[i], sizes[i], payloads[i].size(), options.checksums, crcs[i]);
+            if (!sink.write(head) || !sink.write(payloads[i])) return false;
+            fileCrc = chainCrc(fileCrc, crcs[i]);
+            total += sizes[i];
+        }
+        if (!progress.advance(std::accumulate(sizes.begin(), sizes.begin() + k, (uint64_t)0))) return false;
+    }
+    if (total == 0) return false;
+
+    head.clear();
+    writeBlockTrailer(head, sink.written, offsets, total, options.checksums, fileCrc);
+    return sink.write(head);
+}
+
+bool compressStream(InputStream& in, OutputStream& out, const Options& options) {
+    bool rewindable = in.rewind();
+    bool singleStream = options.format == Format::Legacy || options.format == Format::Canonical;
+    if (singleStream && rewindable)
+        return compressTwoPass(in, out, options);
+    return compressBlocksStream(in, out, options, rewindable);
+}
+
+// Feeds a single-stream bitstream through a fixed input window. Each round
+// decodes until the reader is kChunkSlack bytes from the end of the window,
+// then moves the unread tail to the front and carries the bit buffer over.
+static bool decodeChunked(InputStream& in, OutputStream& out, const Decoder& d, uint64_t originalSize,
+                          Progress* sink) {
+    ProgressTracker progress(sink, originalSize);
+    std::vector<uint8_t> window(kStreamChunk + kChunkSlack);
+    std::vector<uint8_t> decoded(kStreamChunk);
+    size_t filled = 0;
+    uint64_t bits = 0;
+    int count = 0;
+    uint64_t remaining = originalSize;
+    while (remaining > 0) {
+        size_t got = readFully(in, window.data() + filled, window.size() - filled);
+        bool eof = filled + got < window.size();
+        filled += got;
+
+        BitBuffer br(window.data(), filled, 0, bits, count);
+        size_t stop = eof ? SIZE_MAX : filled - kChunkSlack;
+        while (remaining > 0) {
+            size_t want = (size_t)std::min<uint64_t>(remaining, decoded.size());
+            size_t n = decodeSymbols(d.tree, d.table.data(), br, decoded.data(), want, stop);
+            if (br.overrun() || !out.write(decoded.data(), n) || !progress.advance(n)) return false;
+            remaining -= n;
+            if (n < want) break; // window used up
         }
+        if (eof) return remaining == 0;
+
+        size_t used = br.position();
+        std::memmove(window.data(), window.data() + used, filled - used);
+        filled -= used;
+        bits = br.buf;
+        count = br.count;
     }
     return true;
 }
 
+static bool decompressLegacyStream(InputStream& in, OutputStream& out, Progress* progress) {
+    uint8_t fixed[12];
+    if (readFully(in, fixed, 12) != 12) return false;
+    size_t pos = 0;
+    uint64_t originalSize = readUint64(fixed, pos);
+    uint32_t distinct = readUint32(fixed, pos);
+    if (distinct == 0 || distinct > 256) return false;
+
+    std::vector<uint8_t> table(distinct * 9);
+    if (readFully(in, table.data(), table.size()) != table.size()) return false;
+    std::array<uint64_t, 256> freq{};
+    pos = 0;
+    for (uint32_t i = 0; i < distinct; ++i) {
+        uint8_t val = table[pos++];
+        freq[val] = readUint64(table.data(), pos);
+    }
+    HuffTree tree;
+    if (!buildLegacyTree(freq, tree)) return false;
+    Decoder decoder;
+    flattenTree(tree, tree.root(), decoder.tree);
+    decoder.buildTable();
+    return decodeChunked(in, out, decoder, originalSize, progress);
+}
+
+static bool decompressCanonicalStream(InputStream& in, OutputStream& out, Progress* progress) {
+    uint8_t head[10 + 256];
+    if (readFully(in, head, 10) != 10) return false;
+    size_t pos = 0;
+    uint64_t originalSize = readUint64(head, pos);
+    size_t tableBytes = head[9] <= 15 ? head[8] / 2 + 1 : head[8] + 1;
+    if (readFully(in, head + 10, tableBytes) != tableBytes) return false;
+
+    std::array<uint8_t, 256> lengths;
+    Decoder decoder;
+    if (!readLengths(head, 10 + tableBytes, pos, lengths) || !decoder.initCanonical(lengths)) return false;
+    return decodeChunked(in, out, decoder, originalSize, progress);
+}
+
+// Block by block: memory is one block in, one block out
+static bool decompressBlocksStream(InputStream& in, OutputStream& out, Progress* sink) {
+    uint8_t head[5 + 2 + 256];
+    if (readFully(in, head, 5) != 5) return false;
+    size_t pos = 0;
+    size_t blockSize = readUint32(head, pos);
+    uint8_t flags = head[pos++];
+    if (blockSize < kMinBlockSize || blockSize > kMaxBlockSize) return false;
+
+    Decoder shared;
+    bool hasShared = (flags & kFlagSharedTable) != 0;
+    bool checked = (flags & kFlagChecksums) != 0;
+    if (hasShared) {
+        if (readFully(in, head + 5, 2) != 2) return false;
+        size_t tableBytes = head[6] <= 15 ? head[5] / 2 + 1 : head[5] + 1;
+        if (readFully(in, head + 7, tableBytes) != tableBytes) return false;
+        std::array<uint8_t, 256> lengths;
+        if (!readLengths(head, 7 + tableBytes, pos, lengths) || !shared.initCanonical(lengths)) return false;
+    }
+
+    // a payload never exceeds its code table, jump table and 64 bits per byte
+    size_t maxPayload = 2 + 256 + kJumpTableSize + blockSize * 8;
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> block(blockSize);
+    uint64_t total = 0, blocks = 0;
+    uint32_t fileCrc = 0;
+    size_t rest = kBlockHeaderSize - 1 + (checked ? kChecksumSize : 0);
+    ProgressTracker progress(sink, 0); // the original size sits in the footer
+    for (;;) {
+        uint8_t bh[kBlockHeaderSize + kChecksumSize];
+        if (readFully(in, bh, 1) != 1) return false;
+        if (bh[0] == kBlockEnd) break;
+        if (readFully(in, bh + 1, rest) != rest) return false;
+        size_t bpos = 1;
+        size_t raw = readUint32(bh, bpos);
+        size_t size = readUint32(bh, bpos);
+        uint32_t crc = checked ? readUint32(bh, bpos) : 0;
+        if (raw == 0 || raw > blockSize || size > maxPayload) return false;
+        payload.resize(size);
+        if (readFully(in, payload.data(), size) != size) return false;
+
+        if (!decodeBlock(bh[0], payload.data(), size, 0, hasShared ? &shared : nullptr, block.data(), raw))
+            return false;
+        if (checked && Checksum::crc32c(block.data(), raw) != crc) return false;
+        fileCrc = chainCrc(fileCrc, crc);
+        if (!out.write(block.data(), raw) || !progress.advance(raw)) return false;
+        total += raw;
+        blocks++;
+    }
+
+    // The index only matters for random access; check it agrees with what was decoded
+    uint8_t word[8];
+    if (checked) {
+        pos = 0;
+        if (readFully(in, word, kChecksumSize) != kChecksumSize || readUint32(word, pos) != fileCrc) return false;
+    }
+    if (readFully(in, word, 4) != 4) return false;
+    pos = 0;
+    if (readUint32(word, pos) != blocks) return false;
+    for (uint64_t i = 0; i < blocks; ++i)
+        if (readFully(in, word, 8) != 8) return false;
+    uint8_t footer[kFooterSize];
+    if (readFully(in, footer, kFooterSize) != kFooterSize) return false;
+    pos = 0;
+    return readUint64(footer, pos) == total;
+}
+
+bool decompressStream(InputStream& in, OutputStream& out, Progress* progress) {
+    uint8_t magic[4];
+    if (readFully(in, magic, 4) != 4) return false;
+    if (magic[0] != 'H' || magic[1] != 'U' || magic[2] != 'F') return false;
+    switch (magic[3]) {
+    case '1': return decompressLegacyStream(in, out, progress);
+    case '2': return decompressCanonicalStream(in, out, progress);
+    case 'B': return decompressBlocksStream(in, out, progress);
+    default: return false;
+    }
+}
+
+// std::istream / std::ostream adapters
+namespace {
+class StdInput : public InputStream {
+    std::istream& s;
+    std::streampos start;
+public:
+    explicit StdInput(std::istream& in): s(in), start(in.tellg()) {}
+    size_t read(uint8_t* buf, size_t maxSize) override {
+        s.read(reinterpret_cast<char*>(buf), (std::streamsize)maxSize);
+        return (size_t)s.gcount();
+    }
+    bool rewind() override {
+        if (start == std::streampos(-1)) return false;
+        s.clear();
+        s.seekg(start);
+        return (bool)s;
+    }
+};
+
+class StdOutput : public OutputStream {
+    std::ostream& s;
+public:
+    explicit StdOutput(std::ostream& out): s(out) {}
+    bool write(const uint8_t* data, size_t size) override {
+        s.write(reinterpret_cast<const char*>(data), (std::streamsize)size);
+        return (bool)s;
+    }
+};
+
+// verify() of a single stream: decoded chunk by chunk from memory, output dropped
+class MemoryInput : public InputStream {
+    const uint8_t* data;
+    size_t size, pos = 0;
+public:
+    MemoryInput(const uint8_t* in, size_t n): data(in), size(n) {}
+    size_t read(uint8_t* buf, size_t maxSize) override {
+        size_t n = std::min(maxSize, size - pos);
+        std::memcpy(buf, data + pos, n);
+        pos += n;
+        return n;
+    }
+};
+
+class NullOutput : public OutputStream {
+public:
+    bool write(const uint8_t*, size_t) override { return true; }
+};
+} // namespace
+
+bool verify(const uint8_t* in, size_t size, int threads, Progress* progress) {
+    if (!in || size < 4 || in[0] != 'H' || in[1] != 'U' || in[2] != 'F') return false;
+    if (in[3] != 'B') {
+        MemoryInput src(in, size);
+        NullOutput dst;
+        return decompressStream(src, dst, progress);
+    }
+    BlocksView v;
+    if (!readBlocksView(in, size, v)) return false;
+    ProgressTracker tracker(progress, v.originalSize);
+    return decodeBlocks(in, v, 0, v.offsets.size(), threads, nullptr, tracker);
+}
+
+bool compressStream(std::istream& in, std::ostream& out, const Options& options) {
+    StdInput src(in);
+    StdOutput dst(out);
+    return compressStream(src, dst, options);
+}
+
+bool decompressStream(std::istream& in, std::ostream& out) {
+    StdInput src(in);
+    StdOutput dst(out);
+    return decompressStream(src, dst);
+}
+
 } // namespace Huffman
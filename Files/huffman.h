@@ -1,25 +1,156 @@
 #ifndef HUFFMAN_H
 #define HUFFMAN_H
 
+#include <array>
 #include <cstdint>
 #include <vector>
-#include <unordered_map>
-#include <string>
+#include <iosfwd>
 
 /*
   HUFFMAN - DSA LOGIC SUMMARY (highlighted):
-  - Frequency counting: unordered_map<uint8_t, uint64_t>  (O(n) over file bytes)
-  - Huffman tree: min-priority queue (min-heap) built over nodes (O(m log m), m = distinct symbols)
-  - Tree traversal to generate codes: DFS (O(m * avg_code_len))
+  - Frequency counting: 256-entry histogram, 8 interleaved sub-tables, sliced across threads
+    for large inputs (O(n) over file bytes, see histogram.h)
+  - Huffman tree: flat 511-entry node array (no allocation); two-queue merge over the sorted
+    leaves (O(m) after an O(m log m) sort, m = distinct symbols); HUF1 replays the original
+    min-heap merges on node indices so old files keep their exact codes
+  - Codes from the tree: one top-down pass over the array (parents follow their children)
+  - Canonical codes (HUF2): only code lengths are stored; encoder and decoder both reassign
+    codes from the lengths (counting per length, no frequencies, no tree rebuild)
+  - Optional length limit: package-merge over <= 64 levels (O(L * m)) when the tree is too deep
+  - Encoding: codes kept as (bits, length) integers, appended to a 64-bit accumulator that is
+    stored a whole word at a time into an output buffer sized exactly from the histogram
+  - Blocks (HUFB): input split into 1 MB blocks, each coded by a worker thread; a trailing
+    block index lets the decoder give every block to a different thread as well, or decode only
+    the blocks covering a byte range (decompressRange). The block histogram picks the mode
+    before any bit is written: one byte value = run (RLE), predicted Huffman size not smaller
+    = stored as is (a memcpy), else Huffman
+  - Estimate: the same histograms and code lengths give the exact output size and the entropy
+    without encoding (O(256) per histogram); very large inputs are sampled at strided regions
+  - Decoding: 2^11-entry lookup table over a 64-bit bit buffer, up to 2 symbols per lookup;
+    codes longer than 11 bits finish by walking a flattened (index-based) tree
+  - Single streams (HUF1/HUF2, no index) over 2 MB decode in parallel: chunks cut at byte
+    offsets are parsed speculatively, then each is synced to where its predecessor truly ends
+    (Huffman codes self-synchronize within a few symbols) and decoded into its output slot
+  - Interleaved blocks: 4 independent bit readers advance in one loop (no dependency between
+    their code lengths), each table lookup yields whole symbols since codes are capped at 11
+  - Streaming: seekable input = two passes (histogram, then encode) in 1 MB chunks; one-pass
+    input = HUFB with a table per block; decoding resumes the bit buffer across chunks
   - Time overall: O(n + m log m)
-  - Memory: O(m) for map and tree; O(n) only when reading file into memory (we read once)
+  - Memory: O(1) for the histogram, node array and tables; O(n) only for the in-memory API,
+    bounded buffers when streaming; the span API reads mapped input in place and can decode
+    straight into a mapped output file
 */
 
 namespace Huffman {
 
+// Stream formats written by compressBytes; decompressBytes detects either by magic
+enum class Format {
+    Legacy,    // "HUF1": every distinct byte + its 64-bit frequency, decoder rebuilds the tree
+    Canonical, // "HUF2": canonical code lengths only (<= 256 nibbles/bytes), no tree rebuild
+    Blocks,     // "HUFB": independent fixed-size blocks coded on a worker pool, with a block index
+    Interleaved // "HUFB" whose blocks are each split into 4 bitstreams behind a jump table
+                // (Huff0 style), so one core decodes 4 symbols at a time; codes <= 11 bits
+};
+
+// Progress and cooperative cancellation for long calls. update() gets the bytes
+// processed so far (uncompressed side) and the total, 0 while unknown; returning
+// false cancels and the call then fails. It may run on a worker thread, but
+// never on two threads at once.
+class Progress {
+public:
+    virtual ~Progress() = default;
+    virtual bool update(uint64_t done, uint64_t total) = 0;
+};
+
+struct Options {
+    Format format = Format::Canonical;
+    // Canonical/Blocks: cap on code length in bits, 0 = unlimited. With a cap of 11 or
+    // less every code resolves in a single table lookup when decoding. A cap too small
+    // for the number of distinct bytes (e.g. < 8 for all 256) is raised to the minimum.
+    // Interleaved always caps at 11.
+    int maxCodeLength = 0;
+    // Blocks/Interleaved: input bytes per block (clamped to 64 KB..64 MB), worker threads
+    // (0 = one per core; also used when decoding) and whether all blocks share one
+    // code table built from the whole input instead of carrying their own
+    size_t blockSize = 1 << 20;
+    int threads = 0;
+    bool sharedTable = false;
+    // Block formats (HUFB, and the FSE/LZ77 containers): store a CRC-32C of every raw
+    // block, computed by the worker that codes it, plus a file checksum over them.
+    // Decoding checks whatever the file carries; HUF1/HUF2 have no room for either.
+    bool checksums = true;
+    // Optional progress/cancellation hook (not owned)
+    Progress* progress = nullptr;
+};
+
 // Public API
-bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary);
-bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes);
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary, const Options& options = Options());
+// threads: worker count for decoding, 0 = one per core (HUFB blocks, or chunks of a
+// large HUF1/HUF2 stream found by self-synchronization)
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads = 0);
+
+// --- Span API: read-only input in place (e.g. a memory-mapped file), no copy ---
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary, const Options& options = Options());
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads = 0,
+                     Progress* progress = nullptr);
+// Original size recorded in a compressed buffer's header/footer, so the output
+// can be allocated (or a file resized and mapped) before decoding; fails when the
+// buffer is too small to hold that much (at most 8x for HUF1/HUF2)
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize);
+// Decodes into caller memory; outSize must equal decompressedSize()
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads = 0,
+                  Progress* progress = nullptr);
+// Bytes [offset, offset + length) of the original, clipped at its end (fails when
+// offset is past it). HUFB decodes only the blocks covering the range, found through
+// the block index; HUF1/HUF2 have no index and decode from the start up to the range end.
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads = 0);
+
+// --- Pre-flight estimate: output size and entropy before any bit is written ---
+struct Estimate {
+    uint64_t compressedSize = 0; // bytes compressBytes would produce with the same options
+    double entropy = 0;          // Shannon entropy of the byte histogram, bits per byte (0..8)
+    bool exact = true;           // false when extrapolated from strided samples
+};
+// From a histogram alone in O(256): code lengths give the bitstream size, plus the
+// HUF1/HUF2 header (block formats are sized as one HUF2 stream)
+bool estimate(const std::array<uint64_t, 256>& freq, Estimate& out, const Options& options = Options());
+// Exact for inputs up to 64 MB (per block for HUFB, so modes and tables match what
+// compressBytes writes); larger inputs are sampled at 16 strided regions or blocks
+bool estimate(const uint8_t* input, size_t size, Estimate& out, const Options& options = Options());
+
+// Decodes without keeping the output (each worker reuses one scratch block) and
+// checks the block and file CRCs when present: a scrub of stored archives.
+// HUF1/HUF2 can only show that the stream decodes to its recorded size.
+bool verify(const uint8_t* in, size_t size, int threads = 0, Progress* progress = nullptr);
+
+// --- Streaming API: bounded buffers whatever the input size ---
+// Byte source for compressStream/decompressStream. read() returns the number of
+// bytes stored, 0 once the input is exhausted. rewind() seeks back to where the
+// stream started; sources that cannot (pipes, sockets) keep the default.
+class InputStream {
+public:
+    virtual ~InputStream() = default;
+    virtual size_t read(uint8_t* buf, size_t maxSize) = 0;
+    virtual bool rewind() { return false; }
+};
+
+class OutputStream {
+public:
+    virtual ~OutputStream() = default;
+    virtual bool write(const uint8_t* data, size_t size) = 0;
+};
+
+// Rewindable input gets a two-pass HUF1/HUF2 encode (or HUFB if requested);
+// one-pass input always becomes HUFB with a code table per block, threads
+// blocks at a time. Memory stays around (threads + 2) x block size.
+bool compressStream(InputStream& in, OutputStream& out, const Options& options = Options());
+// Any format; single-stream files are decoded in 1 MB chunks, HUFB block by block
+bool decompressStream(InputStream& in, OutputStream& out, Progress* progress = nullptr);
+
+// std::istream/std::ostream front ends (an istream counts as rewindable when tellg() works)
+bool compressStream(std::istream& in, std::ostream& out, const Options& options = Options());
+bool decompressStream(std::istream& in, std::ostream& out);
 
 } // namespace Huffman
 
@@ -1,11 +1,28 @@
 #include "imagecom.h"
+#include "avijoin.h"
+#include "parallel.h"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <thread>
 #include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace ImageCompressor {
 
+// All messages, success included, go to stderr: the CLI keeps stdout for its JSON lines
+
 // --- SINGLE IMAGE COMPRESSION (JPEG Lossy) ---
 // Default quality is set to 75 (assuming you want to keep that change)
 bool compressAndSaveSingleImage(const std::string& inputPath, const std::string& outputPath, int quality) {
@@ -27,58 +44,577 @@ bool compressAndSaveSingleImage(const std::string& inputPath, const std::string&
     if (!success) {
         std::cerr << "ERROR [ImageCom]: Failed to write the compressed image to disk." << std::endl;
     } else {
-        std::cout << "SUCCESS [ImageCom]: Single image compressed and saved to " << outputPath << ". Quality: " << quality << "." << std::endl;
+        std::cerr << "SUCCESS [ImageCom]: Single image compressed and saved to " << outputPath << ". Quality: " << quality << "." << std::endl;
     }
 
     return success;
 }
 
 
-// --- VIDEO COMPRESSION (Optimized XVID Codec) ---
-// Note: JPEG quality parameter is ignored for video codec control.
-bool compressAndSaveVideo(const std::string& inputPath, const std::string& outputPath, int quality) {
-    cv::VideoCapture inputVideo(inputPath);
-    if (!inputVideo.isOpened()) {
+// --- VIDEO CODECS ---
+// The quality reaches each backend through the only control it has: OpenCV's MJPEG
+// writer takes VIDEOWRITER_PROP_QUALITY, while its FFmpeg backend ignores property
+// setters and instead reads encoder options from OPENCV_FFMPEG_WRITER_OPTIONS
+// ("key;value|key;value", OpenCV 4.5.3+) when a writer is opened.
+namespace {
+
+struct CodecInfo {
+    VideoCodec codec;
+    const char* name;
+    char fourcc[4];
+    int api;
+};
+
+const CodecInfo kCodecs[] = {
+    {VideoCodec::Xvid, "XVID", {'X', 'V', 'I', 'D'}, cv::CAP_FFMPEG},
+    {VideoCodec::Mjpeg, "MJPG", {'M', 'J', 'P', 'G'}, cv::CAP_OPENCV_MJPEG},
+    {VideoCodec::H264, "H264", {'H', '2', '6', '4'}, cv::CAP_FFMPEG},
+    {VideoCodec::Hevc, "HEVC", {'H', 'E', 'V', 'C'}, cv::CAP_FFMPEG},
+};
+
+const CodecInfo& codecInfo(VideoCodec codec) {
+    return kCodecs[(int)codec];
+}
+
+const char* const kWriterOptionsVariable = "OPENCV_FFMPEG_WRITER_OPTIONS";
+
+// OpenCV reads its OPENCV_FFMPEG_* variables when a capture or writer is opened, so every
+// open here holds this lock and the writer options only change under it. POSIX setenv
+// is not safe against getenv on other threads: the variable is defined once (by
+// prepareVideoBackend, before any worker starts) and from then on only gets a new value,
+// which never moves the environment array. Threads outside this file that read the
+// environment during a writer open (Qt's own, say) are not covered by the lock.
+std::mutex backendMutex;
+bool backendPrepared = false;
+std::string userWriterOptions; // the variable as the process started, restored after each open
+
+int processId() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
+
+void setEnvironment(const char* name, const std::string& value) {
+#ifdef _WIN32
+    _putenv_s(name, value.c_str()); // the CRT locks its environment itself
+#else
+    setenv(name, value.c_str(), 1); // an empty value reads as "no options"
+#endif
+}
+
+// Caller holds backendMutex
+void prepareLocked() {
+    if (backendPrepared) return;
+    const char* current = std::getenv(kWriterOptionsVariable);
+    userWriterOptions = current ? current : "";
+    setEnvironment(kWriterOptionsVariable, userWriterOptions);
+    backendPrepared = true;
+}
+
+bool openCapture(cv::VideoCapture& capture, const std::string& path) {
+    std::lock_guard<std::mutex> lock(backendMutex);
+    return capture.open(path);
+}
+
+// XVID (mpeg4) has no constant-quality mode worth using, so quality picks a bitrate:
+// 0.02 bits per pixel at 1 up to 0.25 at 100, on a curve that spends most of the range
+// on the visible end. x264/x265 get a CRF from 51 (worst) down to 18.
+std::string ffmpegOptions(VideoCodec codec, int quality, cv::Size size, double fps) {
+    if (codec == VideoCodec::Xvid) {
+        double q = quality / 100.0;
+        double bitsPerPixel = 0.02 + 0.23 * q * q;
+        long long bitrate = (long long)(bitsPerPixel * size.width * size.height * fps);
+        return "b;" + std::to_string(bitrate);
+    }
+    return "crf;" + std::to_string((int)std::lround(51 - 0.33 * quality));
+}
+
+bool openVideoWriter(cv::VideoWriter& writer, const std::string& path, VideoCodec codec, double fps, cv::Size size,
+                     bool isColor, int quality) {
+    const CodecInfo& info = codecInfo(codec);
+    int fourcc = cv::VideoWriter::fourcc(info.fourcc[0], info.fourcc[1], info.fourcc[2], info.fourcc[3]);
+    quality = std::max(1, std::min(100, quality));
+    std::lock_guard<std::mutex> lock(backendMutex);
+    if (info.api != cv::CAP_FFMPEG) {
+        if (!writer.open(path, info.api, fourcc, fps, size, isColor)) return false;
+        writer.set(cv::VIDEOWRITER_PROP_QUALITY, quality);
+        return true;
+    }
+
+    prepareLocked(); // no-op when the application called prepareVideoBackend()
+    setEnvironment(kWriterOptionsVariable, ffmpegOptions(codec, quality, size, fps));
+    bool ok = writer.open(path, info.api, fourcc, fps, size, isColor);
+    setEnvironment(kWriterOptionsVariable, userWriterOptions);
+    return ok;
+}
+
+// The requested codec when this build has it, else the first one it has
+VideoCodec usableCodec(VideoCodec wanted) {
+    std::vector<VideoCodec> available = availableVideoCodecs();
+    if (available.empty() || std::find(available.begin(), available.end(), wanted) != available.end())
+        return wanted;
+    std::cerr << "WARNING [VideoCom]: " << videoCodecName(wanted) << " is not available; using "
+              << videoCodecName(available.front()) << "." << std::endl;
+    return available.front();
+}
+
+} // namespace
+
+void prepareVideoBackend() {
+    std::lock_guard<std::mutex> lock(backendMutex);
+    prepareLocked();
+}
+
+const char* videoCodecName(VideoCodec codec) {
+    return codecInfo(codec).name;
+}
+
+bool videoCodecFromName(const std::string& name, VideoCodec& codec) {
+    for (const CodecInfo& info : kCodecs) {
+        if (name == info.name) {
+            codec = info.codec;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<VideoCodec> availableVideoCodecs() {
+    static const std::vector<VideoCodec> available = [] {
+        std::vector<VideoCodec> found;
+        // Runs on whichever thread asks first (a QtConcurrent worker, say): nothing may throw
+        std::error_code ec;
+        const std::filesystem::path tempDir = std::filesystem::temp_directory_path(ec);
+        if (ec) {
+            std::cerr << "WARNING [VideoCom]: No temporary directory to probe codecs in; assuming only MJPG."
+                      << std::endl;
+            found.push_back(VideoCodec::Mjpeg); // OpenCV's built-in writer, needs no FFmpeg
+            return found;
+        }
+        cv::Mat frame(64, 64, CV_8UC3, cv::Scalar::all(0));
+        for (const CodecInfo& info : kCodecs) {
+            // The PID keeps two processes probing at once off each other's file
+            std::filesystem::path probe = tempDir / ("videocodec_probe_" + std::to_string(processId()) + "_" +
+                                                     info.name + ".avi");
+            cv::VideoWriter writer;
+            if (openVideoWriter(writer, probe.string(), info.codec, 25, frame.size(), true, 75)) {
+                writer.write(frame);
+                writer.release();
+                found.push_back(info.codec);
+            }
+            std::error_code ignored;
+            std::filesystem::remove(probe, ignored);
+        }
+        return found;
+    }();
+    return available;
+}
+
+// --- VIDEO PIPELINE ---
+// decode thread -> [stage workers] -> encoder (the calling thread), over a ring of
+// kPipelineDepth slots. A slot is decoded into, processed and written in place, then
+// handed back to the decoder, so after the first lap no frame memory is allocated.
+// In the frame-parallel MJPEG mode the stage workers also JPEG-encode their frame, so
+// the encoder thread only appends finished JPEGs; the ring keeps them in order.
+// Static frames are found on the decode thread, the one place frames pass in order:
+// each is shrunk to a grey thumbnail and compared (cv::norm, vectorized) with the last
+// kept frame's, and a duplicate skips the stages and the encoder.
+// A frame is megabytes, so one mutex per hand-off costs nothing next to the codecs,
+// and waiting threads sleep on the condition variable instead of spinning.
+namespace {
+
+// Enough slots to ride out jitter on either side; 1080p BGR keeps it near 50 MB
+constexpr int kPipelineDepth = 8;
+
+// Thumbnails for static frame detection: a quarter of each side, so a changed text
+// glyph still moves some thumbnail pixel by far more than sensor noise does
+constexpr double kThumbnailScale = 0.25;
+
+struct FrameSlot {
+    enum State { Free, Decoded, Ready };
+    State state = Free;
+    cv::Mat frame;                    // as decoded
+    cv::Mat scaled, converted;        // stage outputs, reused like the frame
+    const cv::Mat* out = nullptr;     // what the encoder writes
+    std::vector<uchar> jpeg;          // *out as JPEG, in the frame-parallel MJPEG mode
+    bool duplicate = false;           // matches the last kept frame: not processed or encoded
+};
+
+class FramePipeline {
+public:
+    // limit: frames to read from the capture's current position (-1 = to the end);
+    // jpegQuality: also JPEG-encode every frame on the stage workers (0 = off)
+    FramePipeline(cv::VideoCapture& in, const VideoOptions& options, cv::Size outSize, long long limit = -1,
+                  int jpegQuality = 0)
+        : input(in), options(options), outSize(outSize), limit(limit), slots(kPipelineDepth) {
+        if (jpegQuality > 0) jpegParams = {cv::IMWRITE_JPEG_QUALITY, std::max(1, std::min(100, jpegQuality))};
+        hasStages = options.grayscale || !jpegParams.empty() ||
+                    outSize != cv::Size((int)in.get(cv::CAP_PROP_FRAME_WIDTH), (int)in.get(cv::CAP_PROP_FRAME_HEIGHT));
+    }
+
+    // Runs until the input ends or write() returns false; returns the frames written
+    template <typename Write>
+    long long run(Write&& write) {
+        std::vector<std::thread> threads;
+        threads.emplace_back([this] { decode(); });
+        if (hasStages) {
+            int workers = options.threads > 0 ? options.threads : Parallel::defaultThreads();
+            for (int i = 0; i < workers; ++i) threads.emplace_back([this] { process(); });
+        }
+
+        long long written = 0;
+        for (;; ++written) {
+            FrameSlot& slot = slots[written % kPipelineDepth];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return slot.state == FrameSlot::Ready || (ended && written >= decoded); });
+                if (slot.state != FrameSlot::Ready) break;
+            }
+            bool more = write(slot, written + 1);
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.state = FrameSlot::Free;
+            if (!more) stopped = true;
+            changed.notify_all();
+            if (!more) { ++written; break; }
+        }
+        for (auto& t : threads) t.join();
+        return written;
+    }
+
+private:
+    void decode() {
+        for (long long seq = 0;; ++seq) {
+            FrameSlot& slot = slots[seq % kPipelineDepth];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return slot.state == FrameSlot::Free || stopped; });
+                if (stopped) return;
+            }
+            // The slot belongs to this thread until its state changes
+            bool ok = (limit < 0 || seq < limit) && input.read(slot.frame) && !slot.frame.empty();
+            if (ok && !hasStages) slot.out = &slot.frame;
+            if (ok) slot.duplicate = options.duplicateThreshold >= 0 && isDuplicate(slot.frame);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok) {
+                ended = true;
+                changed.notify_all();
+                return;
+            }
+            slot.state = hasStages ? FrameSlot::Decoded : FrameSlot::Ready;
+            decoded = seq + 1;
+            changed.notify_all();
+        }
+    }
+
+    // Compares with the last kept frame, which this frame replaces unless it is a duplicate
+    bool isDuplicate(const cv::Mat& frame) {
+        cv::resize(frame, shrunk, cv::Size(), kThumbnailScale, kThumbnailScale, cv::INTER_AREA);
+        if (shrunk.channels() == 3) cv::cvtColor(shrunk, thumbnail, cv::COLOR_BGR2GRAY);
+        else shrunk.copyTo(thumbnail);
+        if (thumbnail.size() == keptThumbnail.size() &&
+            cv::norm(thumbnail, keptThumbnail, cv::NORM_INF) <= options.duplicateThreshold)
+            return true;
+        std::swap(thumbnail, keptThumbnail);
+        return false;
+    }
+
+    // Stage worker: takes decoded frames in order, any number in flight
+    void process() {
+        for (;;) {
+            long long seq;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return nextToProcess < decoded || ended || stopped; });
+                if (stopped || nextToProcess >= decoded) return;
+                seq = nextToProcess++;
+            }
+            FrameSlot& slot = slots[seq % kPipelineDepth];
+            if (!slot.duplicate) runStages(slot);
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.state = FrameSlot::Ready;
+            changed.notify_all();
+        }
+    }
+
+    void runStages(FrameSlot& slot) {
+        const cv::Mat* current = &slot.frame;
+        if (current->size() != outSize) {
+            cv::resize(*current, slot.scaled, outSize, 0, 0, cv::INTER_AREA);
+            current = &slot.scaled;
+        }
+        if (options.grayscale && current->channels() == 3) {
+            cv::cvtColor(*current, slot.converted, cv::COLOR_BGR2GRAY);
+            current = &slot.converted;
+        }
+        slot.out = current;
+        // An empty buffer tells the encoder the frame could not be encoded
+        if (!jpegParams.empty() && !cv::imencode(".jpg", *current, slot.jpeg, jpegParams)) slot.jpeg.clear();
+    }
+
+    cv::VideoCapture& input;
+    const VideoOptions& options;
+    cv::Size outSize;
+    long long limit;
+    std::vector<int> jpegParams;  // imencode parameters; empty unless frames are JPEG-encoded here
+    bool hasStages = false;
+    std::vector<FrameSlot> slots;
+    cv::Mat shrunk, thumbnail, keptThumbnail;  // static frame detection, decode thread only
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    long long decoded = 0;        // frames read so far
+    long long nextToProcess = 0;  // next frame a stage worker takes
+    bool ended = false;           // input exhausted; decoded is final
+    bool stopped = false;         // encoder gave up (cancelled)
+};
+
+// Where encoded frames go: an OpenCV writer for the codec, or for frame-parallel MJPEG
+// the pipeline's JPEGs stored as they are in an MJPG AVI. Static frames become an
+// empty chunk in the AVI, or the last kept frame again for an OpenCV writer.
+class VideoSink {
+public:
+    bool open(const std::string& path, VideoCodec codec, double fps, cv::Size size, bool isColor, int quality,
+              bool jpegFrames, bool duplicates) {
+        jpeg = jpegFrames;
+        keepLast = duplicates && !jpeg;
+        if (jpeg) return avi.open(path, "MJPG", size.width, size.height, fps);
+        return openVideoWriter(writer, path, codec, fps, size, isColor, quality);
+    }
+
+    // False when the frame could not be stored (JPEG mode only: encode failure, disk
+    // error or the 4 GB AVI limit); cv::VideoWriter::write() reports nothing
+    bool write(const FrameSlot& slot) {
+        if (jpeg) return slot.duplicate ? avi.writeRepeat() : avi.write(slot.jpeg.data(), slot.jpeg.size());
+        if (slot.duplicate) {
+            writer.write(lastKept);
+            return true;
+        }
+        if (keepLast) slot.out->copyTo(lastKept);  // the slot is reused once this returns
+        writer.write(*slot.out);
+        return true;
+    }
+
+    bool release() {
+        if (jpeg) return avi.close();
+        writer.release();
+        return true;
+    }
+
+private:
+    bool jpeg = false;
+    bool keepLast = false;
+    cv::Mat lastKept;
+    cv::VideoWriter writer;
+    AviJoin::FrameWriter avi;
+};
+
+// --- SEGMENT-PARALLEL ENCODING ---
+// The frame range is cut into contiguous segments, each with its own capture (seeked
+// to its first frame), pipeline and writer, encoded side by side into temporary AVIs
+// that AviJoin splices without re-encoding. Anything that would make the splice wrong
+// (inexact seek, short segment, unspliceable parts) reports Unsupported and the
+// caller encodes serially instead.
+
+// Shorter segments cost more in seeks and forced keyframes than they save
+constexpr long long kMinSegmentFrames = 300;
+
+int segmentCount(const VideoOptions& options, long long totalFrames, const std::string& outputPath) {
+    if (options.segments == 1 || totalFrames < 2 * kMinSegmentFrames) return 1;
+    // Segments are spliced as AVI, so the output must be one
+    std::string ext = outputPath.size() >= 4 ? outputPath.substr(outputPath.size() - 4) : std::string();
+    if (ext != ".avi" && ext != ".AVI") return 1;
+    long long wanted = options.segments > 1 ? options.segments
+                     : (options.threads > 0 ? options.threads : Parallel::defaultThreads());
+    return (int)std::max(1LL, std::min(wanted, totalFrames / kMinSegmentFrames));
+}
+
+enum class SegmentResult { Done, Cancelled, Unsupported };
+
+struct EncodeStats {
+    long long frames = 0;      // written, static ones included
+    long long duplicates = 0;  // static frames that skipped the stages and the encoder
+};
+
+SegmentResult encodeSegments(const std::string& inputPath, const std::string& outputPath, VideoCodec codec,
+                             int quality, bool jpegFrames, double fps, cv::Size outSize, long long totalFrames,
+                             int segments, const VideoOptions& options, const ProgressCallback& progress,
+                             EncodeStats& stats) {
+    // Workers are shared out: the segments are the parallelism, stages get the rest
+    int workers = options.threads > 0 ? options.threads : Parallel::defaultThreads();
+    VideoOptions stageOptions = options;
+    stageOptions.threads = std::max(1, workers / segments);
+
+    std::vector<std::string> parts(segments);
+    std::atomic<long long> written(0), duplicates(0);
+    std::atomic<bool> cancelled(false), unsupported(false);
+    std::mutex progressMutex;
+    Parallel::forEach((size_t)segments, segments, [&](size_t i) {
+        long long start = totalFrames * (long long)i / segments;
+        long long end = totalFrames * (long long)(i + 1) / segments;
+        bool last = i + 1 == (size_t)segments;
+        parts[i] = outputPath + ".part" + std::to_string(i) + ".avi";
+
+        cv::VideoCapture capture;
+        if (!openCapture(capture, inputPath) ||
+            (start > 0 && (!capture.set(cv::CAP_PROP_POS_FRAMES, (double)start) ||
+                           (long long)capture.get(cv::CAP_PROP_POS_FRAMES) != start))) {
+            unsupported = true;
+            return;
+        }
+        VideoSink sink;
+        if (!sink.open(parts[i], codec, fps, outSize, !options.grayscale, quality, jpegFrames,
+                       options.duplicateThreshold >= 0)) {
+            unsupported = true;
+            return;
+        }
+        // The last segment runs to the real end in case the container's frame count is short
+        FramePipeline pipeline(capture, stageOptions, outSize, last ? -1 : end - start, jpegFrames ? quality : 0);
+        long long count = pipeline.run([&](const FrameSlot& slot, long long) {
+            if (cancelled || unsupported) return false;
+            if (!sink.write(slot)) {
+                unsupported = true;
+                return false;
+            }
+            if (slot.duplicate) ++duplicates;
+            long long done = ++written;
+            if (progress) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                if (!cancelled && !progress(done, totalFrames)) cancelled = true;
+            }
+            return !cancelled.load();
+        });
+        if (!sink.release() || (!cancelled && !last && count != end - start)) unsupported = true;
+    });
+
+    SegmentResult result = cancelled ? SegmentResult::Cancelled
+                         : unsupported || !AviJoin::concatenate(parts, outputPath) ? SegmentResult::Unsupported
+                         : SegmentResult::Done;
+    for (const std::string& part : parts)
+        if (!part.empty()) std::remove(part.c_str());
+    stats.frames = written;
+    stats.duplicates = duplicates;
+    return result;
+}
+
+enum class SerialResult { Done, Cancelled, OpenFailed, WriteFailed };
+
+// The whole input through one pipeline into one output
+SerialResult encodeSerial(cv::VideoCapture& input, const std::string& outputPath, VideoCodec codec, int quality,
+                          bool jpegFrames, double fps, cv::Size outSize, long long totalFrames,
+                          const VideoOptions& options, const ProgressCallback& progress, EncodeStats& stats) {
+    VideoSink sink;
+    if (!sink.open(outputPath, codec, fps, outSize, !options.grayscale, quality, jpegFrames,
+                   options.duplicateThreshold >= 0))
+        return SerialResult::OpenFailed;
+
+    bool cancelled = false, writeFailed = false;
+
+    // Decode, stages and encode overlap; the codec does the compression.
+    FramePipeline pipeline(input, options, outSize, -1, jpegFrames ? quality : 0);
+    stats.duplicates = 0;
+    stats.frames = pipeline.run([&](const FrameSlot& slot, long long done) {
+        if (!sink.write(slot)) {
+            writeFailed = true;
+            return false;
+        }
+        if (slot.duplicate) ++stats.duplicates;
+        if (progress && !progress(done, totalFrames)) {
+            cancelled = true;
+            return false;
+        }
+        return true;
+    });
+    if (!sink.release()) writeFailed = true;
+
+    return cancelled ? SerialResult::Cancelled : writeFailed ? SerialResult::WriteFailed : SerialResult::Done;
+}
+
+} // namespace
+
+// --- VIDEO COMPRESSION (XVID, MJPG, H.264 or HEVC) ---
+bool compressAndSaveVideo(const std::string& inputPath, const std::string& outputPath, int quality,
+                          const ProgressCallback& progress, const VideoOptions& options) {
+    cv::VideoCapture inputVideo;
+    if (!openCapture(inputVideo, inputPath)) {
         std::cerr << "ERROR [VideoCom]: Could not open or find the input video: " << inputPath << std::endl;
         return false;
     }
 
-    // Checking for .avi extension (best container for XVID)
+    // Checking for .avi extension (the container every codec here can be written to)
     if (outputPath.find(".avi") == std::string::npos && outputPath.find(".AVI") == std::string::npos) {
-        std::cerr << "WARNING [VideoCom]: XVID is used. Output path should end with '.avi' for compatibility." << std::endl;
+        std::cerr << "WARNING [VideoCom]: Output path should end with '.avi' for compatibility." << std::endl;
     }
 
     int frame_width = (int)inputVideo.get(cv::CAP_PROP_FRAME_WIDTH);
     int frame_height = (int)inputVideo.get(cv::CAP_PROP_FRAME_HEIGHT);
     double fps = inputVideo.get(cv::CAP_PROP_FPS);
     if (fps <= 0) fps = 30.0;
+    cv::Size outSize(frame_width, frame_height);
+    if (options.scale > 0 && options.scale != 1.0)
+        outSize = cv::Size(std::max(2, (int)(frame_width * options.scale) & ~1),
+                           std::max(2, (int)(frame_height * options.scale) & ~1));
 
-    // Use XVID codec (MPEG-4) for reliable AVI writing
-    int fourcc = cv::VideoWriter::fourcc('X', 'V', 'I', 'D');
-
-    cv::VideoWriter outputVideo;
-    // Attempt to open the writer
-    if (!outputVideo.open(outputPath, fourcc, fps, cv::Size(frame_width, frame_height), true)) {
-        std::cerr << "ERROR [VideoCom]: Could not open the output video writer for " << outputPath << std::endl;
-        inputVideo.release();
-        return false;
-    }
+    VideoCodec codec = usableCodec(options.codec);
+    const char* codecName = videoCodecName(codec);
+    long long totalFrames = std::max(0LL, (long long)inputVideo.get(cv::CAP_PROP_FRAME_COUNT));
+    // MJPEG frames are independent, so the stage workers JPEG-encode them side by side
+    bool jpegFrames = codec == VideoCodec::Mjpeg;
 
-    cv::Mat frame;
-    long frameCount = 0;
+    // Static frames are reported on success when elimination is on
+    auto staticNote = [&](const EncodeStats& stats) {
+        return options.duplicateThreshold < 0 ? std::string()
+             : " (" + std::to_string(stats.duplicates) + " static frames not encoded)";
+    };
 
-    // Read and Write Loop: Rely entirely on the XVID codec for compression.
-    while (inputVideo.read(frame)) {
-        frameCount++;
-        // NOTE: outputVideo.write() returns void and cannot be checked directly with 'if (!...)'
-        outputVideo.write(frame);
+    // Long videos: segments encoded side by side, then spliced
+    int segments = segmentCount(options, totalFrames, outputPath);
+    if (segments > 1) {
+        EncodeStats stats;
+        SegmentResult r = encodeSegments(inputPath, outputPath, codec, quality, jpegFrames, fps, outSize, totalFrames,
+                                         segments, options, progress, stats);
+        if (r == SegmentResult::Cancelled) {
+            std::cerr << "WARNING [VideoCom]: Cancelled after " << stats.frames << " frames." << std::endl;
+            return false;
+        }
+        if (r == SegmentResult::Done && stats.frames > 0) {
+            std::cerr << "SUCCESS [VideoCom]: Video processed using " << codecName << " codec in " << segments
+                      << " segments. Total frames: " << stats.frames << staticNote(stats) << "." << std::endl;
+            return true;
+        }
+        std::cerr << "WARNING [VideoCom]: Segments could not be joined; encoding serially." << std::endl;
     }
 
+    EncodeStats stats;
+    SerialResult result = encodeSerial(inputVideo, outputPath, codec, quality, jpegFrames, fps, outSize, totalFrames,
+                                       options, progress, stats);
+    // Our MJPG AVI stops at the 4 GB RIFF limit; OpenCV's MJPEG writer goes on into OpenDML
+    if (result == SerialResult::WriteFailed && jpegFrames) {
+        std::cerr << "WARNING [VideoCom]: Frame-parallel MJPEG stopped after " << stats.frames
+                  << " frames; encoding again with the OpenCV writer." << std::endl;
+        if (openCapture(inputVideo, inputPath))
+            result = encodeSerial(inputVideo, outputPath, codec, quality, false, fps, outSize, totalFrames, options,
+                                  progress, stats);
+    }
     inputVideo.release();
-    outputVideo.release();
 
-    if (frameCount > 0) {
-        std::cout << "SUCCESS [VideoCom]: Video processed using XVID codec. Total frames: " << frameCount << "." << std::endl;
+    if (result == SerialResult::OpenFailed) {
+        std::cerr << "ERROR [VideoCom]: Could not open the output video writer for " << outputPath << std::endl;
+        return false;
+    }
+    if (result == SerialResult::Cancelled) {
+        std::cerr << "WARNING [VideoCom]: Cancelled after " << stats.frames << " frames." << std::endl;
+        return false;
+    }
+    if (result == SerialResult::WriteFailed) {
+        std::cerr << "ERROR [VideoCom]: Could not write the output video " << outputPath << std::endl;
+        return false;
+    }
+
+    if (stats.frames > 0) {
+        std::cerr << "SUCCESS [VideoCom]: Video processed using " << codecName << " codec at quality " << quality
+                  << ". Total frames: " << stats.frames << staticNote(stats) << "." << std::endl;
         return true;
     } else {
         std::cerr << "ERROR [VideoCom]: Video file was empty or could not be fully read." << std::endl;
@@ -2,9 +2,71 @@
 #define IMAGECOM_H
 
 #include <string>
+#include <functional>
+#include <vector>
 
 namespace ImageCompressor {
 
+/**
+ * @brief Progress hook for long jobs: receives the frames written so far and the
+ *        total frame count (0 when the container does not report one).
+ *        Returning false cancels the job.
+ */
+using ProgressCallback = std::function<bool(long long done, long long total)>;
+
+/**
+ * @brief Output video codecs. XVID, H.264 and HEVC go through OpenCV's FFmpeg backend.
+ *        MJPG is intra-only: every frame is a JPEG (cv::imencode) encoded on the worker
+ *        pool, reassembled in order and stored as an MJPG AVI, so it scales with cores
+ *        and every frame is a seek point.
+ */
+enum class VideoCodec { Xvid, Mjpeg, H264, Hevc };
+
+/**
+ * @brief Short codec name ("XVID", "MJPG", "H264", "HEVC") as stored in settings.
+ */
+const char* videoCodecName(VideoCodec codec);
+
+/**
+ * @brief Parses a name from videoCodecName(); false for anything else.
+ */
+bool videoCodecFromName(const std::string& name, VideoCodec& codec);
+
+/**
+ * @brief Codecs this OpenCV build can write, probed on first use by encoding one small
+ *        frame with each; the result is cached for the process. Jobs asking for a codec
+ *        that is missing use the first available one instead.
+ */
+std::vector<VideoCodec> availableVideoCodecs();
+
+/**
+ * @brief Call once at startup, before other threads run. The FFmpeg writer takes its
+ *        quality from an environment variable; defining it here means later writer opens
+ *        only replace its value (under a lock) instead of adding it to the environment
+ *        while other threads may be reading it.
+ */
+void prepareVideoBackend();
+
+/**
+ * @brief Video job settings. The stages run on a worker pool between the decode and
+ *        encode threads; with neither stage set, decoded frames go straight to the encoder.
+ *        Segments each run such a pipeline over their own frame range.
+ */
+struct VideoOptions {
+    double scale = 1.0;      // resize stage: factor applied to both sides (1.0 = off)
+    bool grayscale = false;  // colour conversion stage: BGR to one channel
+    int threads = 0;         // workers for segments and stages (0 = one per core)
+    // Long AVI outputs are cut into this many frame ranges, encoded concurrently and
+    // joined without re-encoding (0 = one per worker, at least 300 frames each; 1 = off)
+    int segments = 0;
+    VideoCodec codec = VideoCodec::Xvid;
+    // Static frame elimination (-1 = off): a frame whose quarter-size grey thumbnail differs
+    // from the last kept frame's by at most this much in every pixel (0..255) skips the
+    // stages and the encoder. Timing is kept: MJPEG stores an empty AVI chunk (players hold
+    // the previous frame), other codecs are handed the last kept frame again.
+    int duplicateThreshold = -1;
+};
+
 /**
  * @brief Compresses a single image using JPEG encoding and saves it to disk.
  * @param inputPath Path to the source image file (e.g., .png, .bmp).
@@ -15,13 +77,20 @@ namespace ImageCompressor {
 bool compressAndSaveSingleImage(const std::string& inputPath, const std::string& outputPath, int quality = 75);
 
 /**
- * @brief Loads a video, compresses it frame-by-frame using JPEG encoding, and saves the new video.
+ * @brief Loads a video, re-encodes it with options.codec at the given quality, and saves the new video.
+ *        Decoding and encoding run on their own threads over a small pool of reused frame
+ *        buffers, so the job takes about as long as the slower of the two, not their sum.
  * @param inputPath Path to the source video file (e.g., .mp4, .avi).
  * @param outputPath Path where the compressed video will be saved (e.g., _compressed.mp4).
- * @param quality JPEG compression quality (0-100) applied to each frame.
- * @return true if successful, false otherwise.
+ * @param quality 1-100: JPEG quality for MJPG, the bitrate for XVID (about 0.02 to 0.25
+ *        bits per pixel) and the CRF for H.264/HEVC (51 down to 18).
+ * @param progress Optional hook called after every frame; may cancel the job.
+ * @param options Optional stages, codec, workers, segments and static frame elimination.
+ * @return true if successful, false otherwise (including when cancelled).
  */
-bool compressAndSaveVideo(const std::string& inputPath, const std::string& outputPath, int quality = 75);
+bool compressAndSaveVideo(const std::string& inputPath, const std::string& outputPath, int quality = 75,
+                          const ProgressCallback& progress = ProgressCallback(),
+                          const VideoOptions& options = VideoOptions());
 
 } // namespace ImageCompressor
 
@@ -0,0 +1,419 @@
+#include "lz77.h"
+#include "blockformat.h"
+#include <algorithm>
+#include <cstring>
+
+using BlockFormat::readUint32;
+using BlockFormat::writeUint32;
+using BlockFormat::loadUint32LE;
+using BlockFormat::loadUint64LE;
+
+// Index of the highest set bit (v > 0)
+static inline int highBit(uint32_t v) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(v);
+#else
+    int n = 0;
+    while (v >>= 1) ++n;
+    return n;
+#endif
+}
+
+// Index of the lowest set bit (v > 0)
+static inline int lowBit(uint64_t v) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) { v >>= 1; ++n; }
+    return n;
+#endif
+}
+
+// --- Format constants ---
+// Block types of the LZH1 container (blockformat.h)
+enum : uint8_t { kBlockLz = 0, kBlockStored = 1 };
+static constexpr size_t kMinMatch = 4;
+// A minimum-length match this far back costs about as much as its 4 literals
+static constexpr size_t kMaxShortDistance = 64 * 1024;
+static constexpr int kHashLog = 16;
+static constexpr int kMinWindowLog = 10;
+static constexpr int kMaxWindowLog = 24;
+static constexpr int kDirectCodes = 16;
+static constexpr int kMaxCode = kDirectCodes + 2 * (31 - 4) + 1;
+static constexpr int kStreams = 4; // literals, literal-run codes, match-length codes, offset codes
+
+// --- Match finder ---
+// Search effort per level (zlib's table, adapted): chain links followed, a match
+// length past which only a quarter of the chain is still searched, the length that
+// ends the search, how many times a match may be deferred by one byte (lazy), the
+// length past which it is not deferred any more, and after how many positions
+// without a match (as a power of two) the search starts skipping bytes (0 = never)
+struct LevelParams {
+    int maxChain;
+    size_t goodLength;
+    size_t niceLength;
+    int lazy;
+    size_t maxLazy;
+    int skipLog;
+};
+static const LevelParams kLevels[10] = {
+    {0, 0, 0, 0, 0, 0},            // unused
+    {4, 4, 16, 0, 0, 5},           // 1: greedy, few candidates
+    {8, 4, 32, 0, 0, 6},
+    {16, 8, 32, 1, 8, 6},
+    {32, 8, 64, 1, 16, 7},
+    {64, 8, 128, 1, 32, 7},
+    {128, 8, 128, 1, 32, 8},       // 6: default
+    {256, 32, 256, 1, 128, 0},
+    {1024, 64, 1024, 2, 256, 0},
+    {4096, 256, 4096, 2, 4096, 0}, // 9: deepest search
+};
+
+static inline uint32_t hash4(const uint8_t* p) {
+    return (loadUint32LE(p) * 2654435761u) >> (32 - kHashLog);
+}
+
+// Bytes shared by p and q, at most limit
+static inline size_t matchLength(const uint8_t* p, const uint8_t* q, size_t limit) {
+    size_t len = 0;
+    while (len + 8 <= limit) {
+        uint64_t diff = loadUint64LE(p + len) ^ loadUint64LE(q + len);
+        if (diff) return len + (size_t)(lowBit(diff) >> 3);
+        len += 8;
+    }
+    while (len < limit && p[len] == q[len]) ++len;
+    return len;
+}
+
+class MatchFinder {
+public:
+    MatchFinder(const uint8_t* data, size_t size, int windowLog, const LevelParams& params)
+        : src(data), n(size), window(size_t(1) << windowLog), level(params),
+          head(size_t(1) << kHashLog, -1), prev(window) {}
+
+    // Adds every position before pos to the chains
+    void insertUpTo(size_t pos) {
+        for (; next < pos && next + kMinMatch <= n; ++next) {
+            uint32_t h = hash4(src + next);
+            prev[next & (window - 1)] = head[h];
+            head[h] = (int32_t)next;
+        }
+    }
+
+    // Longest match at pos that is longer than minLen - 1 (0 if none); positions
+    // before pos must be inserted
+    size_t find(size_t pos, size_t minLen, size_t& offset) const {
+        const uint8_t* p = src + pos;
+        const size_t limit = n - pos;
+        size_t best = std::max(minLen, kMinMatch) - 1;
+        size_t found = 0;
+        int chain = best >= level.goodLength ? level.maxChain >> 2 : level.maxChain;
+        int32_t cand = head[hash4(p)];
+        for (; cand >= 0 && chain > 0; --chain) {
+            size_t dist = pos - (size_t)cand;
+            if (dist >= window) break;
+            const uint8_t* q = src + cand;
+            // one byte past the best so far rejects most candidates before the full compare
+            if (best < limit && q[best] == p[best]) {
+                size_t len = matchLength(p, q, limit);
+                if (len > best && (len > kMinMatch || dist <= kMaxShortDistance)) {
+                    best = found = len;
+                    offset = dist;
+                    if (len >= level.niceLength || len == limit) break;
+                    if (len >= level.goodLength && chain > level.maxChain >> 2) chain = level.maxChain >> 2;
+                }
+            }
+            cand = prev[(size_t)cand & (window - 1)];
+        }
+        return found;
+    }
+
+private:
+    const uint8_t* src;
+    size_t n;
+    size_t window;
+    LevelParams level;
+    std::vector<int32_t> head;
+    std::vector<int32_t> prev; // ring indexed by position modulo the window
+    size_t next = 0;
+};
+
+// --- Value coding ---
+// Values below 16 are their own code. A larger value with its top bit at h is sent
+// as code 16 + 2 * (h - 4) + the bit below the top, followed by its low h - 1 bits.
+struct ExtraBits {
+    std::vector<uint8_t> out;
+    uint64_t acc = 0;
+    int count = 0;
+    void add(uint32_t value, int n) {
+        acc |= uint64_t(value) << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((uint8_t)acc);
+            acc >>= 8;
+            count -= 8;
+        }
+    }
+    void finish() {
+        if (count > 0) out.push_back((uint8_t)acc);
+        acc = 0;
+        count = 0;
+    }
+};
+
+static inline uint8_t encodeValue(uint32_t v, ExtraBits& extra) {
+    if (v < kDirectCodes) return (uint8_t)v;
+    int h = highBit(v);
+    extra.add(v & ((1u << (h - 1)) - 1), h - 1);
+    return (uint8_t)(kDirectCodes + 2 * (h - 4) + ((v >> (h - 1)) & 1));
+}
+
+class ExtraReader {
+public:
+    ExtraReader(const uint8_t* data, size_t size): p(data), end(data + size) {}
+    uint32_t read(int n) {
+        while (count < n) {
+            if (p == end) { overrun = true; return 0; }
+            acc |= uint64_t(*p++) << count;
+            count += 8;
+        }
+        uint32_t v = (uint32_t)(acc & ((uint64_t(1) << n) - 1));
+        acc >>= n;
+        count -= n;
+        return v;
+    }
+    bool ok() const { return !overrun; }
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t acc = 0;
+    int count = 0;
+    bool overrun = false;
+};
+
+static inline uint32_t decodeValue(uint8_t code, ExtraReader& extra) {
+    if (code < kDirectCodes) return code;
+    int h = (code - kDirectCodes) / 2 + 4;
+    return (1u << h) | (uint32_t(code & 1) << (h - 1)) | extra.read(h - 1);
+}
+
+// --- Blocks ---
+// Each stream is stored as its size (4) and a canonical Huffman buffer; empty streams
+// are just the size
+static bool appendStream(std::vector<uint8_t>& out, const std::vector<uint8_t>& data) {
+    if (data.empty()) {
+        writeUint32(out, 0);
+        return true;
+    }
+    Huffman::Options options;
+    options.format = Huffman::Format::Canonical;
+    options.maxCodeLength = 11; // single-lookup decoding
+    options.threads = 1;
+    std::vector<uint8_t> coded;
+    if (!Huffman::compressBytes(data, coded, options)) return false;
+    writeUint32(out, (uint32_t)coded.size());
+    out.insert(out.end(), coded.begin(), coded.end());
+    return true;
+}
+
+// Parses src[0, n) into sequences and codes them; payload layout:
+// sequence count (4) | 4 Huffman streams | extra bits size (4) | extra bits
+static void encodeBlock(const uint8_t* src, size_t n, int windowLog, const LevelParams& level,
+                        BlockFormat::EncodedBlock& block) {
+    std::vector<uint8_t> streams[kStreams];
+    std::vector<uint8_t>& literals = streams[0];
+    ExtraBits extra;
+    literals.reserve(n);
+    uint32_t sequences = 0;
+
+    // a short (last) block needs no more window than its own length
+    while (windowLog > kMinWindowLog && (size_t(1) << (windowLog - 1)) >= n) --windowLog;
+    MatchFinder finder(src, n, windowLog, level);
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + kMinMatch <= n) {
+        finder.insertUpTo(pos);
+        size_t offset = 0;
+        size_t len = finder.find(pos, kMinMatch, offset);
+        if (!len) {
+            // incompressible stretch (e.g. an embedded JPEG): search ever more sparsely
+            pos += level.skipLog ? 1 + ((pos - anchor) >> level.skipLog) : 1;
+            continue;
+        }
+        // Lazy matching: take the next position instead while it has a longer match
+        for (int step = 0; step < level.lazy && len < level.maxLazy && pos + 1 + kMinMatch <= n; ++step) {
+            finder.insertUpTo(pos + 1);
+            size_t nextOffset = 0;
+            size_t nextLen = finder.find(pos + 1, len + 1, nextOffset);
+            if (!nextLen) break;
+            ++pos;
+            len = nextLen;
+            offset = nextOffset;
+        }
+
+        literals.insert(literals.end(), src + anchor, src + pos);
+        streams[1].push_back(encodeValue((uint32_t)(pos - anchor), extra));
+        streams[2].push_back(encodeValue((uint32_t)(len - kMinMatch), extra));
+        streams[3].push_back(encodeValue((uint32_t)(offset - 1), extra));
+        ++sequences;
+        pos += len;
+        anchor = pos;
+    }
+    literals.insert(literals.end(), src + anchor, src + n);
+    extra.finish();
+
+    block.payload.clear();
+    writeUint32(block.payload, sequences);
+    bool ok = true;
+    for (int s = 0; s < kStreams && ok; ++s) ok = appendStream(block.payload, streams[s]);
+    writeUint32(block.payload, (uint32_t)extra.out.size());
+    block.payload.insert(block.payload.end(), extra.out.begin(), extra.out.end());
+
+    // Nothing gained (or the coder failed): keep the bytes as they are
+    if (!ok || block.payload.size() >= n) {
+        block.type = kBlockStored;
+        block.payload.assign(src, src + n);
+        return;
+    }
+    block.type = kBlockLz;
+}
+
+static bool readStream(const uint8_t* in, size_t size, size_t& pos, std::vector<uint8_t>& data) {
+    if (size - pos < 4) return false;
+    size_t len = readUint32(in, pos);
+    if (len > size - pos) return false;
+    data.clear();
+    if (len && !Huffman::decompressBytes(in + pos, len, data, 1)) return false;
+    pos += len;
+    return true;
+}
+
+// Copies a match of len bytes from offset back; the two ranges may overlap
+static inline void copyMatch(uint8_t* dst, size_t offset, size_t len) {
+    const uint8_t* from = dst - offset;
+    if (offset >= 8) {
+        for (; len >= 8; len -= 8, dst += 8, from += 8) std::memcpy(dst, from, 8);
+    } else if (offset == 1) {
+        std::memset(dst, *from, len);
+        return;
+    }
+    for (size_t i = 0; i < len; ++i) dst[i] = from[i];
+}
+
+static bool decodeBlock(uint8_t type, const uint8_t* payload, size_t size, uint8_t* dst, size_t raw) {
+    if (type == kBlockStored) {
+        if (size != raw) return false;
+        std::memcpy(dst, payload, raw);
+        return true;
+    }
+    if (type != kBlockLz || size < 4) return false;
+
+    size_t pos = 0;
+    size_t sequences = readUint32(payload, pos);
+    if (sequences > raw / kMinMatch) return false;
+    std::vector<uint8_t> streams[kStreams];
+    for (int s = 0; s < kStreams; ++s)
+        if (!readStream(payload, size, pos, streams[s])) return false;
+    for (int s = 1; s < kStreams; ++s)
+        if (streams[s].size() != sequences) return false;
+    if (size - pos < 4) return false;
+    size_t extraSize = readUint32(payload, pos);
+    if (extraSize != size - pos) return false;
+    ExtraReader extra(payload + pos, extraSize);
+
+    const std::vector<uint8_t>& literals = streams[0];
+    if (literals.size() > raw) return false;
+    size_t lit = 0;
+    size_t op = 0;
+    for (size_t i = 0; i < sequences; ++i) {
+        if (streams[1][i] > kMaxCode || streams[2][i] > kMaxCode || streams[3][i] > kMaxCode) return false;
+        size_t litLen = decodeValue(streams[1][i], extra);
+        size_t matchLen = decodeValue(streams[2][i], extra) + kMinMatch;
+        size_t offset = (size_t)decodeValue(streams[3][i], extra) + 1;
+        if (litLen > literals.size() - lit || litLen > raw - op) return false;
+        std::memcpy(dst + op, literals.data() + lit, litLen);
+        lit += litLen;
+        op += litLen;
+        if (offset > op || matchLen > raw - op) return false;
+        copyMatch(dst + op, offset, matchLen);
+        op += matchLen;
+    }
+    size_t rest = literals.size() - lit;
+    if (rest != raw - op || !extra.ok()) return false;
+    std::memcpy(dst + op, literals.data() + lit, rest);
+    return true;
+}
+
+// A coded payload is always smaller than its raw block (else it is stored)
+static const BlockFormat::Codec kCodec = { "LZH1", 0, decodeBlock };
+
+static const LevelParams& levelParams(int level) {
+    return kLevels[std::min(std::max(level, 1), 9)];
+}
+
+// Window: as asked, but no larger than a block (matches never leave it)
+static int windowLogFor(int windowLog, size_t blockSize) {
+    int log = std::min(std::max(windowLog, kMinWindowLog), kMaxWindowLog);
+    while (log > kMinWindowLog && (size_t(1) << (log - 1)) >= blockSize) --log;
+    return log;
+}
+
+// The block encoder for these options (window and level as clamped for the block size)
+static BlockFormat::BlockEncoder blockEncoder(const Lz77::Options& options) {
+    int windowLog = windowLogFor(options.windowLog, BlockFormat::clampBlockSize(options.blockSize));
+    const LevelParams& level = levelParams(options.level);
+    return [windowLog, &level](const uint8_t* src, size_t n, BlockFormat::EncodedBlock& block) {
+        encodeBlock(src, n, windowLog, level, block);
+    };
+}
+
+namespace Lz77 {
+
+bool isLz77(const uint8_t* in, size_t size) {
+    return BlockFormat::hasMagic(kCodec, in, size);
+}
+
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary, const Options& options) {
+    return BlockFormat::compressBytes(kCodec, blockEncoder(options), input, size, outBinary, options);
+}
+
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary, const Options& options) {
+    return Lz77::compressBytes(input.data(), input.size(), outBinary, options);
+}
+
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize) {
+    return BlockFormat::decompressedSize(kCodec, in, size, outSize);
+}
+
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads, Huffman::Progress* sink) {
+    return BlockFormat::decompressTo(kCodec, in, size, out, outSize, threads, sink);
+}
+
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads) {
+    return BlockFormat::decompressRange(kCodec, in, size, offset, length, out, threads);
+}
+
+bool verify(const uint8_t* in, size_t size, int threads, Huffman::Progress* sink) {
+    return BlockFormat::verify(kCodec, in, size, threads, sink);
+}
+
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads, Huffman::Progress* progress) {
+    return BlockFormat::decompressBytes(kCodec, in, size, outBytes, threads, progress);
+}
+
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads) {
+    return Lz77::decompressBytes(inBinary.data(), inBinary.size(), outBytes, threads);
+}
+
+// --- Streaming API ---
+bool compressStream(Huffman::InputStream& in, Huffman::OutputStream& out, const Options& options) {
+    return BlockFormat::compressStream(kCodec, blockEncoder(options), in, out, options);
+}
+
+bool decompressStream(Huffman::InputStream& in, Huffman::OutputStream& out, Huffman::Progress* sink) {
+    return BlockFormat::decompressStream(kCodec, in, out, sink);
+}
+
+} // namespace Lz77
@@ -0,0 +1,67 @@
+#ifndef LZ77_H
+#define LZ77_H
+
+#include <cstdint>
+#include <vector>
+#include "huffman.h"
+
+/*
+  LZ77 + HUFFMAN (DEFLATE-style pipeline), DSA LOGIC SUMMARY:
+  - Match finding: hash of the next 4 bytes -> head table (2^16 entries) holding the latest
+    position with that hash; prev[] (one entry per window byte, used as a ring) links every
+    position to the previous one with the same hash, so candidates are walked newest first
+  - Levels 1..9 trade speed for ratio: how many chain links are followed, the length that is
+    "good enough" to stop searching, and lazy matching (a match is deferred while the next
+    position has a longer one)
+  - Parse result: sequences (literal run length, match length, offset) plus the literal bytes
+  - Entropy stage: literals, literal-run codes, match-length codes and offset codes are four
+    byte streams, each coded with the canonical Huffman coder; a value is sent as a code
+    (itself below 16, else its top two bits) plus raw extra bits in a fifth stream
+  - Blocks: input split into 4 MB blocks, each parsed and coded by a worker thread; matches
+    never cross a block, so decoding is parallel too. Blocks LZ77 cannot shrink are stored.
+  - Container "LZH1": block size (4) | blocks: type (1) | raw size (4) | payload size (4) |
+    [CRC-32C of the raw block (4), when type bit 7 is set] | payload ... | end 0xFF, or 0xFE +
+    file checksum (4, CRC-32C of the block CRCs) | original size (8)
+  - Time: O(n * chain) to compress, O(n) to decompress; memory: window + 2^16 ints per worker
+*/
+
+namespace Lz77 {
+
+// Huffman::Options plus the match finder settings. blockSize, threads and progress
+// apply as for Huffman (blocks default to 4 MB here); format, maxCodeLength and
+// sharedTable are ignored.
+struct Options : Huffman::Options {
+    int level = 6;          // 1 (fastest) .. 9 (smallest)
+    int windowLog = 20;     // match distance up to 2^windowLog - 1 (10..24, at most the block)
+    Options() { blockSize = 4 << 20; }
+};
+
+bool compressBytes(const uint8_t* input, size_t size, std::vector<uint8_t>& outBinary,
+                   const Options& options = Options());
+bool compressBytes(const std::vector<uint8_t>& input, std::vector<uint8_t>& outBinary,
+                   const Options& options = Options());
+
+// True when the buffer starts with the LZ77 magic
+bool isLz77(const uint8_t* in, size_t size);
+// Original size from the footer; fails when it is more than the blocks present can
+// hold, so the result is safe to allocate
+bool decompressedSize(const uint8_t* in, size_t size, uint64_t& outSize);
+bool decompressTo(const uint8_t* in, size_t size, uint8_t* out, size_t outSize, int threads = 0,
+                  Huffman::Progress* progress = nullptr);
+// Bytes [offset, offset + length) of the original, clipped at its end; only the
+// blocks covering the range are decoded (block headers are hopped over to find them)
+bool decompressRange(const uint8_t* in, size_t size, uint64_t offset, size_t length, std::vector<uint8_t>& out,
+                     int threads = 0);
+// Decodes every block into per-worker scratch memory and checks the CRCs, keeping no output
+bool verify(const uint8_t* in, size_t size, int threads = 0, Huffman::Progress* progress = nullptr);
+bool decompressBytes(const uint8_t* in, size_t size, std::vector<uint8_t>& outBytes, int threads = 0,
+                     Huffman::Progress* progress = nullptr);
+bool decompressBytes(const std::vector<uint8_t>& inBinary, std::vector<uint8_t>& outBytes, int threads = 0);
+
+// Block by block with bounded memory; decompressStream reads and checks the magic itself
+bool compressStream(Huffman::InputStream& in, Huffman::OutputStream& out, const Options& options = Options());
+bool decompressStream(Huffman::InputStream& in, Huffman::OutputStream& out, Huffman::Progress* progress = nullptr);
+
+} // namespace Lz77
+
+#endif // LZ77_H
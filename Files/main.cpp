@@ -1,12 +1,18 @@
 #include <QApplication>
+#include <QtConcurrent/QtConcurrentRun>
+#include "imagecom.h"
 #include "mainwindow.h"
 
 int main(int argc, char *argv[]) {
+    // Before QApplication: it may start threads of its own
+    ImageCompressor::prepareVideoBackend();
     QApplication app(argc, argv);
 
+    // Probe the video encoders off the UI thread; the result is cached for the codec list and jobs
+    QtConcurrent::run([] { ImageCompressor::availableVideoCodecs(); });
+
     MainWindow window;
     window.show();
 
     return app.exec();
 }
-
@@ -128,6 +128,14 @@ void MainWindow::setupConnections()
                 }
             });
     
+    // Batch runs arrive as one list so each window saves/refreshes once
+    connect(compressWindow, &CompressWindow::batchCompressionCompleted,
+            dashboardWindow, &DashboardWindow::addBatchStats);
+    connect(compressWindow, &CompressWindow::batchCompressionCompleted,
+            visualizerWindow, &VisualizerWindow::addCompressionBatch);
+    connect(compressWindow, &CompressWindow::batchCompressionCompleted,
+            historyWindow, &HistoryWindow::addCompressionRecords);
+    
     // Connect decompression completion to history
     connect(decompressWindow, &DecompressWindow::decompressionCompleted,
             historyWindow, [this](const QString &fileType, qint64 compressedSize, qint64 decompressedSize) {
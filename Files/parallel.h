@@ -0,0 +1,47 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+  PARALLEL - minimal fork/join helper for the compression engine:
+  - forEach(count, threads, fn) runs fn(i) for i in [0, count) on up to `threads` std::threads
+  - Work is handed out through one atomic counter, so uneven items balance themselves
+  - The calling thread takes part, and nothing is spawned when a single thread is enough
+*/
+
+namespace Parallel {
+
+// Worker count to use when the caller passes 0 ("auto")
+inline int defaultThreads() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw ? (int)hw : 1;
+}
+
+template <typename Fn>
+void forEach(size_t count, int threads, Fn&& fn) {
+    if (threads <= 0) threads = defaultThreads();
+    size_t workers = std::min(count, (size_t)threads);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+} // namespace Parallel
+
+#endif // PARALLEL_H
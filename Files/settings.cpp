@@ -8,6 +8,18 @@
 #include <QDir>
 #include <QFileDialog>
 #include "styledmessagebox.h"
+#include "imagecom.h"
+
+// Codec names as the combo shows them
+static QString videoCodecLabel(ImageCompressor::VideoCodec codec)
+{
+    switch (codec) {
+    case ImageCompressor::VideoCodec::Mjpeg: return "MJPG (Motion JPEG)";
+    case ImageCompressor::VideoCodec::H264: return "H.264 (FFmpeg)";
+    case ImageCompressor::VideoCodec::Hevc: return "HEVC (FFmpeg)";
+    default: return "XVID (MPEG-4)";
+    }
+}
 
 SettingsWindow::SettingsWindow(QWidget *parent)
     : QWidget(parent)
@@ -249,6 +261,79 @@ void SettingsWindow::setupContentArea()
     vidQualLayout->addStretch();
     compLayout->addLayout(vidQualLayout);
 
+    // Video Codec: only what this OpenCV build can write (probed once per run)
+    QHBoxLayout *codecLayout = new QHBoxLayout();
+    QLabel *codecLabel = new QLabel("🎞️ Video Codec:", compressionGroup);
+    codecLabel->setStyleSheet("color: #7dd3fc; font-size: 17px; font-weight: bold; padding: 5px 0px;");
+    codecLabel->setMinimumWidth(240);
+    videoCodecCombo = new QComboBox(compressionGroup);
+    for (ImageCompressor::VideoCodec codec : ImageCompressor::availableVideoCodecs())
+        videoCodecCombo->addItem(videoCodecLabel(codec), QString(ImageCompressor::videoCodecName(codec)));
+    videoCodecCombo->setStyleSheet(R"(
+        QComboBox {
+            background: qlineargradient(x1:0, y1:0, x2:0, y2:1,
+                stop:0 rgba(14, 165, 233, 0.4),
+                stop:1 rgba(2, 132, 199, 0.35));
+            color: #ffffff;
+            border: 2px solid rgba(14, 165, 233, 0.6);
+            border-radius: 15px;
+            padding: 12px 18px;
+            font-size: 16px;
+            font-weight: bold;
+            min-width: 180px;
+        }
+        QComboBox:hover {
+            background: qlineargradient(x1:0, y1:0, x2:0, y2:1,
+                stop:0 rgba(14, 165, 233, 0.5),
+                stop:1 rgba(2, 132, 199, 0.45));
+            border: 2px solid #0ea5e9;
+        }
+        QComboBox:focus {
+            border: 2px solid #38bdf8;
+        }
+        QComboBox::drop-down {
+            border: none;
+            width: 35px;
+            background: transparent;
+        }
+        QComboBox::down-arrow {
+            image: none;
+            border-left: 6px solid transparent;
+            border-right: 6px solid transparent;
+            border-top: 8px solid #ffffff;
+            width: 0;
+            height: 0;
+        }
+        QComboBox QAbstractItemView {
+            background: rgba(30, 58, 138, 0.95);
+            border: 2px solid rgba(14, 165, 233, 0.6);
+            border-radius: 10px;
+            selection-background-color: rgba(14, 165, 233, 0.5);
+            color: #ffffff;
+            padding: 5px;
+        }
+    )");
+    codecLayout->addWidget(codecLabel);
+    codecLayout->addWidget(videoCodecCombo);
+    codecLayout->addStretch();
+    compLayout->addLayout(codecLayout);
+
+    // Static Frames: frames that barely differ from the last kept one are not encoded again;
+    // the value is the largest grey-level change still counted as the same frame (Off = -1)
+    QHBoxLayout *staticLayout = new QHBoxLayout();
+    QLabel *staticLabel = new QLabel("🖥️ Skip Static Frames:", compressionGroup);
+    staticLabel->setStyleSheet("color: #7dd3fc; font-size: 17px; font-weight: bold; padding: 5px 0px;");
+    staticLabel->setMinimumWidth(240);
+    duplicateThresholdSpin = new QSpinBox(compressionGroup);
+    duplicateThresholdSpin->setRange(-1, 64);
+    duplicateThresholdSpin->setSpecialValueText("Off");
+    duplicateThresholdSpin->setValue(-1);
+    duplicateThresholdSpin->setStyleSheet(videoQualitySpin->styleSheet());
+    staticLayout->addWidget(staticLabel);
+    staticLayout->addWidget(duplicateThresholdSpin);
+    staticLayout->addStretch();
+    compLayout->addLayout(staticLayout);
+
     scrollLayout->addWidget(compressionGroup);
 
     // General Settings Group
@@ -672,6 +757,9 @@ void SettingsWindow::loadSettings()
     // Load compression settings
     imageQualitySpin->setValue(settings.value("settings/imageQuality", 85).toInt());
     videoQualitySpin->setValue(settings.value("settings/videoQuality", 70).toInt());
+    int codecIndex = videoCodecCombo->findData(settings.value("settings/videoCodec", "XVID").toString());
+    videoCodecCombo->setCurrentIndex(qMax(0, codecIndex));
+    duplicateThresholdSpin->setValue(settings.value("settings/videoDuplicateThreshold", -1).toInt());
     
     // Load general settings
     QString defaultPath = settings.value("settings/defaultPath", QDir::homePath()).toString();
@@ -691,6 +779,8 @@ void SettingsWindow::saveSettings()
     // Save compression settings
     settings.setValue("settings/imageQuality", imageQualitySpin->value());
     settings.setValue("settings/videoQuality", videoQualitySpin->value());
+    settings.setValue("settings/videoCodec", videoCodecCombo->currentData().toString());
+    settings.setValue("settings/videoDuplicateThreshold", duplicateThresholdSpin->value());
     
     // Save general settings
     settings.setValue("settings/defaultPath", defaultPathEdit->text());
@@ -717,6 +807,8 @@ void SettingsWindow::resetToDefaults()
     // Reset to default values
     imageQualitySpin->setValue(85);
     videoQualitySpin->setValue(70);
+    videoCodecCombo->setCurrentIndex(qMax(0, videoCodecCombo->findData("XVID")));
+    duplicateThresholdSpin->setValue(-1);
     defaultPathEdit->setText(QDir::homePath());
     themeCombo->setCurrentIndex(0);
     
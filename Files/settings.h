@@ -77,6 +77,8 @@ private:
     QGroupBox *compressionGroup;
     QSpinBox *imageQualitySpin;
     QSpinBox *videoQualitySpin;
+    QComboBox *videoCodecCombo;
+    QSpinBox *duplicateThresholdSpin;
     
     QGroupBox *generalGroup;
     QLineEdit *defaultPathEdit;
@@ -474,7 +474,25 @@ void VisualizerWindow::saveCompressionHistory()
 
 void VisualizerWindow::addCompressionData(const QString &fileType, qint64 originalSize, qint64 compressedSize)
 {
-    if (originalSize <= 0) return;
+    if (!appendCompressionData(fileType, originalSize, compressedSize)) return;
+    saveCompressionHistory();
+    updateCharts();
+}
+
+void VisualizerWindow::addCompressionBatch(const QVector<BatchRecord> &records)
+{
+    bool added = false;
+    for (const BatchRecord &record : records) {
+        added |= appendCompressionData(record.fileType, record.originalSize, record.compressedSize);
+    }
+    if (!added) return;
+    saveCompressionHistory();
+    updateCharts();
+}
+
+bool VisualizerWindow::appendCompressionData(const QString &fileType, qint64 originalSize, qint64 compressedSize)
+{
+    if (originalSize <= 0) return false;
     
     CompressionRecord record;
     record.date = QDate::currentDate();
@@ -488,9 +506,7 @@ void VisualizerWindow::addCompressionData(const QString &fileType, qint64 origin
     if (compressionHistory.size() > 100) {
         compressionHistory = compressionHistory.mid(compressionHistory.size() - 100);
     }
-    
-    saveCompressionHistory();
-    updateCharts();
+    return true;
 }
 
 void VisualizerWindow::updateCharts()
@@ -21,6 +21,8 @@
 #include <QDate>
 #include <QMap>
 #include <QResizeEvent>
+#include <QVector>
+#include "compressionjob.h"
 
 class VisualizerWindow : public QWidget
 {
@@ -32,6 +34,8 @@ public:
     
     // Public method to add new compression data
     void addCompressionData(const QString &fileType, qint64 originalSize, qint64 compressedSize);
+    // Batch version: appends every record, then saves and redraws the charts once
+    void addCompressionBatch(const QVector<BatchRecord> &records);
 
 signals:
     void navigateToDashboard();
@@ -57,6 +61,7 @@ private:
     void updateCharts();
     void loadCompressionHistory();
     void saveCompressionHistory();
+    bool appendCompressionData(const QString &fileType, qint64 originalSize, qint64 compressedSize);
     void updateResponsiveSizes();
     
     // Data storage